@@ -0,0 +1,777 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ArchiveReader.h"
+
+#include "Config.h"
+
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+#include <cstring>
+#include <zlib.h>
+
+static const qint64 BUFFER_SIZE = 65536;
+static const qint64 MAX_CENTRAL_DIRECTORY = 268435456;
+static const int    MAX_META_SIZE = 1048576;
+
+static const quint32 ZIP_LOCAL_HEADER   = 0x04034B50;
+static const quint32 ZIP_CENTRAL_HEADER = 0x02014B50;
+static const quint32 ZIP_END_OF_DIR     = 0x06054B50;
+static const quint32 ZIP64_END_OF_DIR   = 0x06064B50;
+static const quint32 ZIP64_LOCATOR      = 0x07064B50;
+
+static const QString VIRTUAL_SEPARATOR("!/");
+
+//=======================================================================================
+// Utility Functions
+//=======================================================================================
+
+static inline quint16 READ_U16(const char *p)
+{
+	const quint8 *const b = reinterpret_cast<const quint8*>(p);
+	return quint16(b[0] | (b[1] << 8));
+}
+
+static inline quint32 READ_U32(const char *p)
+{
+	return quint32(READ_U16(p)) | (quint32(READ_U16(p + 2)) << 16);
+}
+
+static inline quint64 READ_U64(const char *p)
+{
+	return quint64(READ_U32(p)) | (quint64(READ_U32(p + 4)) << 32);
+}
+
+static inline QString NORMALIZE_NAME(QString name)
+{
+	name.replace(QChar('\\'), QChar('/'));
+	while(name.startsWith("./") || name.startsWith(QChar('/')))
+	{
+		name.remove(0, name.startsWith(QChar('/')) ? 1 : 2);
+	}
+	return name;
+}
+
+//=======================================================================================
+// Stream Adapters
+//=======================================================================================
+
+/*receives the decompressed data in pieces of up to 64 KB*/
+class StreamSink
+{
+public:
+	virtual ~StreamSink(void) {}
+	virtual bool consume(const char *data, const qint64 &len) = 0;
+};
+
+/*forwards the decompressed member data to the handler*/
+class MemberSink : public StreamSink
+{
+public:
+	MemberSink(ArchiveReader::Handler *handler) : m_handler(handler), m_aborted(false) {}
+
+	virtual bool consume(const char *data, const qint64 &len)
+	{
+		m_aborted = !m_handler->memberData(data, len);
+		return !m_aborted;
+	}
+
+	inline bool isAborted(void) const { return m_aborted; }
+
+protected:
+	ArchiveReader::Handler *const m_handler;
+	bool m_aborted;
+};
+
+/*incremental parser for the (ustar, GNU or pax) TAR format*/
+class TarParser : public StreamSink
+{
+public:
+	TarParser(ArchiveReader::Handler *handler);
+	virtual bool consume(const char *data, const qint64 &len);
+
+	qint64 skippable(void) const;
+	void skip(void);
+
+	inline bool isDone(void) const    { return m_done;    }
+	inline bool hasError(void) const  { return m_error;   }
+	inline bool isAborted(void) const { return m_aborted; }
+
+protected:
+	typedef enum
+	{
+		STATE_HEADER  = 0,
+		STATE_DATA    = 1,
+		STATE_META    = 2,
+		STATE_PADDING = 3
+	}
+	state_t;
+
+	void parseHeader(void);
+	void enterData(const int &state, const qint64 &size);
+	void endData(void);
+	void parseMeta(void);
+	QString getField(const int &offset, const int &len) const;
+	qint64 getNumber(const int &offset, const int &len) const;
+
+	ArchiveReader::Handler *const m_handler;
+
+	char m_header[512];
+	int m_headerLen;
+	int m_zeroBlocks;
+
+	int m_state;
+	qint64 m_dataLeft;
+	qint64 m_padLeft;
+	bool m_want;
+
+	char m_metaType;
+	QByteArray m_meta;
+	QString m_longName;
+	QString m_paxPath;
+	qint64 m_paxSize;
+
+	bool m_done;
+	bool m_error;
+	bool m_aborted;
+};
+
+TarParser::TarParser(ArchiveReader::Handler *handler)
+:
+	m_handler(handler)
+{
+	m_headerLen = m_zeroBlocks = 0;
+	m_state = STATE_HEADER;
+	m_dataLeft = m_padLeft = 0;
+	m_want = false;
+	m_metaType = 0;
+	m_paxSize = -1;
+	m_done = m_error = m_aborted = false;
+}
+
+bool TarParser::consume(const char *data, const qint64 &len)
+{
+	qint64 pos = 0;
+
+	while((pos < len) && (!(m_done || m_error || m_aborted)))
+	{
+		if(m_state == STATE_HEADER)
+		{
+			const int count = int(qMin(qint64(512 - m_headerLen), len - pos));
+			memcpy(&m_header[m_headerLen], &data[pos], count);
+			m_headerLen += count;
+			pos += count;
+			if(m_headerLen == 512)
+			{
+				m_headerLen = 0;
+				parseHeader();
+			}
+			continue;
+		}
+
+		const qint64 count = qMin((m_state == STATE_PADDING) ? m_padLeft : m_dataLeft, len - pos);
+		if((m_state == STATE_DATA) && m_want)
+		{
+			if(!m_handler->memberData(&data[pos], count))
+			{
+				m_aborted = true;
+				break;
+			}
+		}
+		else if((m_state == STATE_META) && ((m_meta.size() + count) <= MAX_META_SIZE))
+		{
+			m_meta.append(&data[pos], int(count));
+		}
+		pos += count;
+
+		if(m_state == STATE_PADDING)
+		{
+			if((m_padLeft -= count) == 0)
+			{
+				m_state = STATE_HEADER;
+			}
+		}
+		else if((m_dataLeft -= count) == 0)
+		{
+			endData();
+		}
+	}
+
+	return !(m_done || m_error || m_aborted);
+}
+
+qint64 TarParser::skippable(void) const
+{
+	if((m_state == STATE_DATA) && (!m_want))
+	{
+		return m_dataLeft + m_padLeft;
+	}
+	return (m_state == STATE_PADDING) ? m_padLeft : 0;
+}
+
+void TarParser::skip(void)
+{
+	if(skippable() > 0)
+	{
+		m_dataLeft = m_padLeft = 0;
+		m_state = STATE_HEADER;
+	}
+}
+
+void TarParser::parseHeader(void)
+{
+	bool allZero = true;
+	quint32 checksum = 0;
+
+	for(int i = 0; i < 512; i++)
+	{
+		allZero = allZero && (m_header[i] == 0);
+		checksum += ((i >= 148) && (i < 156)) ? quint32(' ') : quint32(quint8(m_header[i]));
+	}
+
+	if(allZero)
+	{
+		m_done = (++m_zeroBlocks >= 2); /*end of archive*/
+		return;
+	}
+
+	m_zeroBlocks = 0;
+
+	if(qint64(checksum) != getNumber(148, 8))
+	{
+		qWarning("TAR header checksum mismatch!");
+		m_error = true;
+		return;
+	}
+
+	const char type = m_header[156];
+	qint64 size = getNumber(124, 12);
+
+	if((type == 'L') || (type == 'x'))
+	{
+		m_metaType = type;
+		m_meta.clear();
+		enterData(STATE_META, size);
+		return;
+	}
+
+	QString name = getField(0, 100);
+	if((memcmp(&m_header[257], "ustar", 5) == 0) && (m_header[345] != 0))
+	{
+		name = QString("%1/%2").arg(getField(345, 155), name);
+	}
+
+	if(!m_longName.isEmpty()) name = m_longName;
+	if(!m_paxPath.isEmpty()) name = m_paxPath;
+	if(m_paxSize >= 0) size = m_paxSize;
+
+	m_longName.clear();
+	m_paxPath.clear();
+	m_paxSize = -1;
+
+	if(size < 0)
+	{
+		m_error = true;
+		return;
+	}
+
+	name = NORMALIZE_NAME(name);
+	m_want = ((type == '0') || (type == '\0') || (type == '7')) && (!name.isEmpty()) && m_handler->wantMember(name, size);
+	enterData(STATE_DATA, size);
+}
+
+void TarParser::enterData(const int &state, const qint64 &size)
+{
+	m_state = state;
+	m_dataLeft = size;
+	m_padLeft = (512 - (size % 512)) % 512;
+
+	if(size == 0)
+	{
+		endData();
+	}
+}
+
+void TarParser::endData(void)
+{
+	if((m_state == STATE_DATA) && m_want)
+	{
+		m_handler->memberDone();
+	}
+	else if(m_state == STATE_META)
+	{
+		parseMeta();
+	}
+
+	m_want = false;
+	m_state = (m_padLeft > 0) ? STATE_PADDING : STATE_HEADER;
+}
+
+void TarParser::parseMeta(void)
+{
+	if(m_metaType == 'L')
+	{
+		m_longName = QString::fromUtf8(m_meta.constData()); /*NUL-terminated*/
+		return;
+	}
+
+	/*pax records have the form "<length> <key>=<value>\n"*/
+	int pos = 0;
+	while(pos < m_meta.size())
+	{
+		const int space = m_meta.indexOf(' ', pos);
+		const int recordLen = (space > pos) ? m_meta.mid(pos, space - pos).toInt() : 0;
+		if((recordLen <= (space - pos + 1)) || ((pos + recordLen) > m_meta.size()))
+		{
+			break;
+		}
+		const QByteArray record = m_meta.mid(space + 1, recordLen - (space - pos) - 2);
+		const int equals = record.indexOf('=');
+		if(equals > 0)
+		{
+			const QByteArray key = record.left(equals);
+			if(key == "path")
+			{
+				m_paxPath = QString::fromUtf8(record.constData() + equals + 1, record.size() - equals - 1);
+			}
+			else if(key == "size")
+			{
+				m_paxSize = record.mid(equals + 1).toLongLong();
+			}
+		}
+		pos += recordLen;
+	}
+}
+
+QString TarParser::getField(const int &offset, const int &len) const
+{
+	int count = 0;
+	while((count < len) && (m_header[offset + count] != 0))
+	{
+		count++;
+	}
+	return QString::fromUtf8(&m_header[offset], count);
+}
+
+qint64 TarParser::getNumber(const int &offset, const int &len) const
+{
+	qint64 value = 0;
+
+	if(quint8(m_header[offset]) & 0x80)
+	{
+		/*GNU base-256 encoding for large values*/
+		value = m_header[offset] & 0x7F;
+		for(int i = 1; i < len; i++)
+		{
+			value = (value << 8) | quint8(m_header[offset + i]);
+		}
+		return value;
+	}
+
+	int i = 0;
+	while((i < len) && ((m_header[offset + i] == ' ') || (m_header[offset + i] == 0)))
+	{
+		i++;
+	}
+	while((i < len) && (m_header[offset + i] >= '0') && (m_header[offset + i] <= '7'))
+	{
+		value = (value << 3) | (m_header[offset + i++] - '0');
+	}
+	return value;
+}
+
+//=======================================================================================
+// Decompression
+//=======================================================================================
+
+/*
+ * Inflates up to inputLimit bytes (or the rest of the file, if negative) with zlib, as
+ * bundled with Qt. The windowBits select a "raw" Deflate stream or a GZip file; in the
+ * latter case, concatenated GZip members are decoded one after another.
+ */
+static bool INFLATE_STREAM(QFile &file, qint64 inputLimit, const int &windowBits, StreamSink *sink, quint64 &totalOut)
+{
+	const bool gzip = (windowBits > MAX_WBITS);
+	QByteArray inBuffer(int(BUFFER_SIZE), '\0'), outBuffer(int(BUFFER_SIZE), '\0');
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(z_stream));
+	totalOut = 0;
+
+	if(inflateInit2(&stream, windowBits) != Z_OK)
+	{
+		qWarning("Failed to initialize the Deflate decoder!");
+		return false;
+	}
+
+	int status = Z_OK;
+	bool outputFull = false;
+	forever
+	{
+		if((stream.avail_in == 0) && (!outputFull)) /*zlib may still hold output, if the buffer was filled*/
+		{
+			const qint64 readLen = (inputLimit < 0) ? BUFFER_SIZE : qMin(BUFFER_SIZE, inputLimit);
+			const qint64 len = (readLen > 0) ? file.read(inBuffer.data(), readLen) : 0;
+			if(len <= 0)
+			{
+				break; /*end of input*/
+			}
+			if(inputLimit >= 0)
+			{
+				inputLimit -= len;
+			}
+			stream.next_in = reinterpret_cast<Bytef*>(inBuffer.data());
+			stream.avail_in = uInt(len);
+		}
+
+		if(gzip && (status == Z_STREAM_END))
+		{
+			inflateReset(&stream); /*next GZip member*/
+		}
+
+		stream.next_out = reinterpret_cast<Bytef*>(outBuffer.data());
+		stream.avail_out = uInt(BUFFER_SIZE);
+		status = inflate(&stream, Z_NO_FLUSH);
+		if((status != Z_OK) && (status != Z_STREAM_END))
+		{
+			break; /*corrupted data or trailing garbage*/
+		}
+
+		const qint64 outLen = BUFFER_SIZE - qint64(stream.avail_out);
+		outputFull = (stream.avail_out == 0);
+		totalOut += quint64(outLen);
+		if((outLen > 0) && (!sink->consume(outBuffer.constData(), outLen)))
+		{
+			break;
+		}
+
+		if((status == Z_STREAM_END) && (!gzip))
+		{
+			break;
+		}
+	}
+
+	inflateEnd(&stream);
+	return (status == Z_STREAM_END);
+}
+
+//=======================================================================================
+// Public Functions
+//=======================================================================================
+
+bool ArchiveReader::isArchive(const QString &path)
+{
+	const QString lower = path.toLower();
+	return lower.endsWith(".zip") || lower.endsWith(".tar") || lower.endsWith(".tar.gz") || lower.endsWith(".tgz");
+}
+
+/*the members of a compressed TAR file can not be listed without inflating all of them*/
+bool ArchiveReader::isCompressed(const QString &path)
+{
+	const QString lower = path.toLower();
+	return lower.endsWith(".tar.gz") || lower.endsWith(".tgz");
+}
+
+bool ArchiveReader::splitPath(const QString &virtualPath, QString &archivePath, QString &memberName)
+{
+	int pos = virtualPath.indexOf(VIRTUAL_SEPARATOR);
+	while(pos > 0)
+	{
+		if(isArchive(virtualPath.left(pos)))
+		{
+			archivePath = virtualPath.left(pos);
+			memberName = virtualPath.mid(pos + VIRTUAL_SEPARATOR.length());
+			return !memberName.isEmpty();
+		}
+		pos = virtualPath.indexOf(VIRTUAL_SEPARATOR, pos + 1);
+	}
+	return false;
+}
+
+QString ArchiveReader::makePath(const QString &archivePath, const QString &memberName)
+{
+	return QString("%1%2%3").arg(archivePath, VIRTUAL_SEPARATOR, memberName);
+}
+
+bool ArchiveReader::process(const QString &archivePath, Handler *handler)
+{
+	QFile file(archivePath);
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Failed to open archive: %s", archivePath.toUtf8().constData());
+		return false;
+	}
+
+	const QString lower = archivePath.toLower();
+	const bool success = lower.endsWith(".zip") ? processZip(file, handler) : processTar(file, handler, (!lower.endsWith(".tar")));
+
+	file.close();
+	return success;
+}
+
+//=======================================================================================
+// Internal Functions
+//=======================================================================================
+
+typedef struct
+{
+	QString name;
+	quint16 flags;
+	quint16 method;
+	quint64 compressedSize;
+	quint64 size;
+	quint64 offset;
+}
+zipEntry_t;
+
+static bool zipEntryLessThan(const zipEntry_t &a, const zipEntry_t &b)
+{
+	return a.offset < b.offset;
+}
+
+bool ArchiveReader::processZip(QFile &file, Handler *handler)
+{
+	const qint64 fileSize = file.size();
+	if(fileSize < 22)
+	{
+		return false;
+	}
+
+	/*the end of central directory record is followed by a comment of up to 64 KB*/
+	const qint64 tailSize = qMin(fileSize, qint64(65557));
+	if(!file.seek(fileSize - tailSize))
+	{
+		return false;
+	}
+
+	const QByteArray tail = file.read(tailSize);
+	int eocd = tail.size() - 22;
+	while((eocd >= 0) && (READ_U32(tail.constData() + eocd) != ZIP_END_OF_DIR))
+	{
+		eocd--;
+	}
+	if(eocd < 0)
+	{
+		qWarning("ZIP end of central directory not found!");
+		return false;
+	}
+
+	const char *const eocdPtr = tail.constData() + eocd;
+	quint64 entryCount = READ_U16(eocdPtr + 10), dirSize = READ_U32(eocdPtr + 12), dirOffset = READ_U32(eocdPtr + 16);
+
+	if((entryCount == 0xFFFF) || (dirSize == 0xFFFFFFFF) || (dirOffset == 0xFFFFFFFF))
+	{
+		if((eocd < 20) || (READ_U32(eocdPtr - 20) != ZIP64_LOCATOR) || (!file.seek(READ_U64(eocdPtr - 12))))
+		{
+			return false;
+		}
+		const QByteArray record = file.read(56);
+		if((record.size() < 56) || (READ_U32(record.constData()) != ZIP64_END_OF_DIR))
+		{
+			return false;
+		}
+		entryCount = READ_U64(record.constData() + 32);
+		dirSize = READ_U64(record.constData() + 40);
+		dirOffset = READ_U64(record.constData() + 48);
+	}
+
+	if((dirSize > quint64(MAX_CENTRAL_DIRECTORY)) || ((dirOffset + dirSize) > quint64(fileSize)) || (!file.seek(dirOffset)))
+	{
+		return false;
+	}
+
+	const QByteArray directory = file.read(dirSize);
+	if(quint64(directory.size()) != dirSize)
+	{
+		return false;
+	}
+
+	QList<zipEntry_t> entries;
+	const char *const dirPtr = directory.constData();
+	int pos = 0;
+
+	for(quint64 i = 0; i < entryCount; i++)
+	{
+		if(((pos + 46) > directory.size()) || (READ_U32(dirPtr + pos) != ZIP_CENTRAL_HEADER))
+		{
+			qWarning("ZIP central directory is corrupted!");
+			return false;
+		}
+
+		const int nameLen = READ_U16(dirPtr + pos + 28), extraLen = READ_U16(dirPtr + pos + 30), commentLen = READ_U16(dirPtr + pos + 32);
+		if((pos + 46 + nameLen + extraLen + commentLen) > directory.size())
+		{
+			return false;
+		}
+
+		zipEntry_t entry;
+		entry.flags = READ_U16(dirPtr + pos + 8);
+		entry.method = READ_U16(dirPtr + pos + 10);
+		entry.compressedSize = READ_U32(dirPtr + pos + 20);
+		entry.size = READ_U32(dirPtr + pos + 24);
+		entry.offset = READ_U32(dirPtr + pos + 42);
+
+		/*bit 11 indicates UTF-8 names, otherwise the OEM code page was used*/
+		const QByteArray rawName(dirPtr + pos + 46, nameLen);
+		entry.name = (entry.flags & 0x0800) ? QString::fromUtf8(rawName.constData(), nameLen) : QString::fromLocal8Bit(rawName.constData(), nameLen);
+
+		/*the ZIP64 extra field holds those values that did not fit into 32 bits*/
+		const char *extra = dirPtr + pos + 46 + nameLen;
+		const char *const extraEnd = extra + extraLen;
+		while((extra + 4) <= extraEnd)
+		{
+			const quint16 extraId = READ_U16(extra), extraSize = READ_U16(extra + 2);
+			if(extraId == 0x0001)
+			{
+				const char *value = extra + 4;
+				quint64 *const fields[3] = { &entry.size, &entry.compressedSize, &entry.offset };
+				for(int k = 0; k < 3; k++)
+				{
+					if((*fields[k] == 0xFFFFFFFF) && ((value + 8) <= qMin(extraEnd, extra + 4 + extraSize)))
+					{
+						*fields[k] = READ_U64(value);
+						value += 8;
+					}
+				}
+			}
+			extra += 4 + extraSize;
+		}
+
+		pos += 46 + nameLen + extraLen + commentLen;
+		entry.name = NORMALIZE_NAME(entry.name);
+
+		if((!entry.name.isEmpty()) && (!entry.name.endsWith(QChar('/'))) && (!(entry.flags & 0x0001)))
+		{
+			entries << entry; /*skip directories and encrypted members*/
+		}
+	}
+
+	/*read the members in the order they are stored*/
+	qSort(entries.begin(), entries.end(), zipEntryLessThan);
+
+	for(QList<zipEntry_t>::ConstIterator iter = entries.constBegin(); iter != entries.constEnd(); iter++)
+	{
+		if(!handler->wantMember(iter->name, qint64(iter->size)))
+		{
+			continue;
+		}
+
+		if(!file.seek(iter->offset))
+		{
+			continue;
+		}
+
+		const QByteArray localHeader = file.read(30);
+		if((localHeader.size() < 30) || (READ_U32(localHeader.constData()) != ZIP_LOCAL_HEADER))
+		{
+			qWarning("ZIP local header not found: %s", iter->name.toUtf8().constData());
+			continue;
+		}
+
+		if(!file.seek(iter->offset + 30 + READ_U16(localHeader.constData() + 26) + READ_U16(localHeader.constData() + 28)))
+		{
+			continue;
+		}
+
+		if(iter->method == 0)
+		{
+			/*stored members are hashed straight from the archive*/
+			qint64 remaining = (iter->compressedSize == iter->size) ? qint64(iter->size) : -1;
+			while(remaining > 0)
+			{
+				const QByteArray buffer = file.read(qMin(remaining, BUFFER_SIZE));
+				if(buffer.isEmpty())
+				{
+					break;
+				}
+				if(!handler->memberData(buffer.constData(), buffer.size()))
+				{
+					return false;
+				}
+				remaining -= buffer.size();
+			}
+			if(remaining == 0)
+			{
+				handler->memberDone();
+			}
+		}
+		else if(iter->method == 8)
+		{
+			MemberSink sink(handler);
+			quint64 totalOut = 0;
+			const bool success = INFLATE_STREAM(file, qint64(iter->compressedSize), -MAX_WBITS, &sink, totalOut) && (totalOut == iter->size);
+			if(sink.isAborted())
+			{
+				return false;
+			}
+			if(success)
+			{
+				handler->memberDone();
+			}
+		}
+		else
+		{
+			qWarning("ZIP compression method %u is not supported: %s", uint(iter->method), iter->name.toUtf8().constData());
+		}
+	}
+
+	return true;
+}
+
+bool ArchiveReader::processTar(QFile &file, Handler *handler, const bool &compressed)
+{
+	TarParser parser(handler);
+	bool success = true;
+
+	if(compressed)
+	{
+		quint64 totalOut = 0;
+		success = INFLATE_STREAM(file, -1, MAX_WBITS + 16, &parser, totalOut) || parser.isDone();
+	}
+	else
+	{
+		while(!(parser.isDone() || parser.hasError() || parser.isAborted()))
+		{
+			/*unwanted member data is skipped, not read*/
+			const qint64 skipLen = parser.skippable();
+			if(skipLen > 0)
+			{
+				if(!file.seek(file.pos() + skipLen))
+				{
+					break;
+				}
+				parser.skip();
+				continue;
+			}
+			const QByteArray buffer = file.read(BUFFER_SIZE);
+			if(buffer.isEmpty())
+			{
+				break;
+			}
+			parser.consume(buffer.constData(), buffer.size());
+		}
+	}
+
+	return success && (!(parser.hasError() || parser.isAborted()));
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+
+class QFile;
+
+//=======================================================================================
+
+/*
+ * Enumerates the members of ZIP and TAR archives, including GZip-compressed TAR files,
+ * without extracting anything to disk. A member is addressed by a "virtual" path of the
+ * form "archive.zip!/dir/file". The Handler decides which members to read; the content
+ * of those members is passed to the Handler as a stream.
+ */
+
+class ArchiveReader
+{
+public:
+	class Handler
+	{
+	public:
+		virtual ~Handler(void) {}
+		virtual bool wantMember(const QString &name, const qint64 &size) = 0;
+		virtual bool memberData(const char *data, const qint64 &len) = 0;
+		virtual void memberDone(void) = 0;
+	};
+
+	static bool isArchive(const QString &path);
+	static bool isCompressed(const QString &path);
+	static bool splitPath(const QString &virtualPath, QString &archivePath, QString &memberName);
+	static QString makePath(const QString &archivePath, const QString &memberName);
+	static bool process(const QString &archivePath, Handler *handler);
+
+private:
+	ArchiveReader(void) {}
+	~ArchiveReader(void) {}
+
+	static bool processZip(QFile &file, Handler *handler);
+	static bool processTar(QFile &file, Handler *handler, const bool &compressed);
+};
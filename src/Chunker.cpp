@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Chunker.h"
+
+#include <cstring>
+
+static const quint64 HASH_SEED = 0x9E3779B97F4A7C15ui64;
+static const quint64 HASH_MULT = 0xC6A4A7935BD1E995ui64;
+static const int     HASH_SHFT = 47;
+
+/*the "small" mask is harder to satisfy than the "large" one (normalized chunking)*/
+static const quint64 MASK_S = 0xFFFFC00000000000ui64; /*18 Bits*/
+static const quint64 MASK_L = 0xFFFC000000000000ui64; /*14 Bits*/
+
+//=======================================================================================
+// Gear Table
+//=======================================================================================
+
+static class GearTable
+{
+public:
+	GearTable(void)
+	{
+		quint64 state = 0x2545F4914F6CDD1Dui64;
+		for(int i = 0; i < 256; i++)
+		{
+			/*SplitMix64 generator*/
+			quint64 z = (state += 0x9E3779B97F4A7C15ui64);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ui64;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBui64;
+			values[i] = z ^ (z >> 31);
+		}
+	}
+
+	quint64 values[256];
+}
+GEAR;
+
+static inline quint64 MIX_WORD(quint64 k)
+{
+	k *= HASH_MULT;
+	k ^= k >> HASH_SHFT;
+	k *= HASH_MULT;
+	return k;
+}
+
+//=======================================================================================
+// Constructor & Destructor
+//=======================================================================================
+
+Chunker::Chunker(void)
+{
+	reset();
+}
+
+Chunker::~Chunker(void)
+{
+}
+
+//=======================================================================================
+// Public Functions
+//=======================================================================================
+
+void Chunker::reset(void)
+{
+	m_chunks.clear();
+	m_chunkSize = 0;
+	m_fingerprint = 0;
+	m_hashState = HASH_SEED;
+	m_hashTailLen = 0;
+}
+
+void Chunker::update(const char *data, const qint64 &len)
+{
+	const quint8 *ptr = (const quint8*) data;
+	qint64 remaining = len;
+
+	while(remaining > 0)
+	{
+		bool found = false;
+		const qint64 consumed = findCutPoint(ptr, remaining, found);
+		
+		hashUpdate(ptr, consumed);
+		ptr += consumed;
+		remaining -= consumed;
+
+		if(found)
+		{
+			const chunk_t chunk = { hashFinal(), m_chunkSize };
+			m_chunks << chunk;
+			m_chunkSize = 0;
+			m_fingerprint = 0;
+		}
+	}
+}
+
+void Chunker::finish(void)
+{
+	if(m_chunkSize > 0)
+	{
+		const chunk_t chunk = { hashFinal(), m_chunkSize };
+		m_chunks << chunk;
+		m_chunkSize = 0;
+		m_fingerprint = 0;
+	}
+}
+
+//=======================================================================================
+// Internal Functions
+//=======================================================================================
+
+qint64 Chunker::findCutPoint(const quint8 *data, const qint64 &len, bool &found)
+{
+	quint32 size = m_chunkSize;
+	quint64 fp = m_fingerprint;
+	qint64 pos = 0;
+
+	found = false;
+
+	/*the first MIN_SIZE bytes of a chunk never contain a cut-point*/
+	if(size < MIN_SIZE)
+	{
+		const qint64 skip = qMin(len, qint64(MIN_SIZE - size));
+		size += quint32(skip);
+		pos += skip;
+	}
+
+	/*use the harder mask until the average chunk size is reached*/
+	if(size < AVG_SIZE)
+	{
+		const qint64 start = pos, end = qMin(len, pos + qint64(AVG_SIZE - size));
+		while(pos < end)
+		{
+			fp = (fp << 1) + GEAR.values[data[pos++]];
+			if(!(fp & MASK_S))
+			{
+				found = true;
+				break;
+			}
+		}
+		size += quint32(pos - start);
+	}
+
+	/*use the easier mask until the maximum chunk size is reached*/
+	if((!found) && (size >= AVG_SIZE))
+	{
+		const qint64 start = pos, end = qMin(len, pos + qint64(MAX_SIZE - size));
+		while(pos < end)
+		{
+			fp = (fp << 1) + GEAR.values[data[pos++]];
+			if(!(fp & MASK_L))
+			{
+				found = true;
+				break;
+			}
+		}
+		size += quint32(pos - start);
+	}
+
+	if(size >= MAX_SIZE)
+	{
+		found = true;
+	}
+
+	m_chunkSize = size;
+	m_fingerprint = fp;
+	return pos;
+}
+
+void Chunker::hashUpdate(const quint8 *data, qint64 len)
+{
+	if(m_hashTailLen > 0)
+	{
+		while((m_hashTailLen < 8) && (len > 0))
+		{
+			m_hashTail[m_hashTailLen++] = *(data++);
+			len--;
+		}
+		if(m_hashTailLen < 8)
+		{
+			return;
+		}
+		quint64 word;
+		memcpy(&word, m_hashTail, 8);
+		m_hashState = (m_hashState ^ MIX_WORD(word)) * HASH_MULT;
+		m_hashTailLen = 0;
+	}
+
+	/*one multiply-xorshift round per 64-Bit word, each round depends on the previous state*/
+	while(len >= 8)
+	{
+		quint64 word;
+		memcpy(&word, data, 8);
+		m_hashState = (m_hashState ^ MIX_WORD(word)) * HASH_MULT;
+		data += 8;
+		len -= 8;
+	}
+
+	while(len > 0)
+	{
+		m_hashTail[m_hashTailLen++] = *(data++);
+		len--;
+	}
+}
+
+quint64 Chunker::hashFinal(void)
+{
+	quint64 h = m_hashState ^ (quint64(m_chunkSize) * HASH_MULT);
+
+	for(quint32 i = 0; i < m_hashTailLen; i++)
+	{
+		h = (h ^ quint64(m_hashTail[i])) * HASH_MULT;
+	}
+
+	h ^= h >> HASH_SHFT;
+	h *= HASH_MULT;
+	h ^= h >> HASH_SHFT;
+
+	m_hashState = HASH_SEED;
+	m_hashTailLen = 0;
+	return h;
+}
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QVector>
+
+//=======================================================================================
+
+/*
+ * Content-defined chunking, following the FastCDC approach: Cut-points are found with a
+ * "Gear" rolling hash and normalized chunking, the first MIN_SIZE bytes of every chunk
+ * are skipped. Each chunk is identified by a 64-Bit digest that is computed word-wise.
+ */
+
+class Chunker
+{
+public:
+	Chunker(void);
+	~Chunker(void);
+
+	typedef struct
+	{
+		quint64 hash;
+		quint32 size;
+	}
+	chunk_t;
+
+	static const quint32 MIN_SIZE =  16384;
+	static const quint32 AVG_SIZE =  65536;
+	static const quint32 MAX_SIZE = 262144;
+
+	void reset(void);
+	void update(const char *data, const qint64 &len);
+	void finish(void);
+
+	inline const QVector<chunk_t> &chunks(void) const { return m_chunks; }
+
+protected:
+	qint64 findCutPoint(const quint8 *data, const qint64 &len, bool &found);
+	void hashUpdate(const quint8 *data, qint64 len);
+	quint64 hashFinal(void);
+
+	quint32 m_chunkSize;
+	quint64 m_fingerprint;
+
+	quint64 m_hashState;
+	quint8  m_hashTail[8];
+	quint32 m_hashTailLen;
+
+	QVector<chunk_t> m_chunks;
+};
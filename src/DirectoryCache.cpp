@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DirectoryCache.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QMutexLocker>
+
+static const quint32 CACHE_MAGIC   = 0x44534443; /*"DSDC"*/
+static const quint32 CACHE_VERSION = 1;
+static const quint8  RECORD_DIR    = 0x01;
+static const quint8  RECORD_EOF    = 0xFF;
+
+//=======================================================================================
+// Directory Cache
+//=======================================================================================
+
+DirectoryCache::DirectoryCache(void)
+:
+	m_hitCount(0),
+	m_missCount(0)
+{
+}
+
+DirectoryCache::~DirectoryCache(void)
+{
+}
+
+bool DirectoryCache::load(const QString &inFile)
+{
+	clear();
+
+	QFile file(inFile);
+	if(!file.exists())
+	{
+		qDebug("Directory cache does not exist yet: %s", inFile.toUtf8().constData());
+		return true;
+	}
+
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Failed to open directory cache: %s", inFile.toUtf8().constData());
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_8);
+
+	quint32 magic = 0, version = 0;
+	stream >> magic >> version;
+
+	if((stream.status() != QDataStream::Ok) || (magic != CACHE_MAGIC) || (version != CACHE_VERSION))
+	{
+		qWarning("Not a valid directory cache: %s", inFile.toUtf8().constData());
+		return false;
+	}
+
+	QHash<QString, listing_t> listings;
+	quint64 recordCount = 0;
+
+	forever
+	{
+		quint8 type = 0;
+		stream >> type;
+
+		if(type == RECORD_DIR)
+		{
+			QByteArray directory;
+			quint32 entryCount = 0;
+			listing_t listing;
+			stream >> directory >> listing.mtime >> listing.ctime >> entryCount;
+			for(quint32 i = 0; (i < entryCount) && (stream.status() == QDataStream::Ok); i++)
+			{
+				QByteArray name;
+				DirectoryWalker::entry_t entry;
+				stream >> name >> entry.size >> entry.mtime >> entry.attributes;
+				entry.name = QString::fromUtf8(name.constData(), name.size());
+				listing.entries << entry;
+			}
+			if(stream.status() != QDataStream::Ok)
+			{
+				break;
+			}
+			listings.insert(QString::fromUtf8(directory.constData(), directory.size()), listing);
+			recordCount++;
+		}
+		else if(type == RECORD_EOF)
+		{
+			quint64 expectedCount = 0;
+			stream >> expectedCount;
+			if((stream.status() == QDataStream::Ok) && (expectedCount == recordCount))
+			{
+				m_previous.swap(listings);
+				qDebug("Loaded %u cached directories.", quint32(m_previous.count()));
+				return true;
+			}
+			break;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	/*an incomplete cache is not used at all, every directory will be listed again*/
+	qWarning("Directory cache is truncated or corrupted: %s", inFile.toUtf8().constData());
+	return false;
+}
+
+bool DirectoryCache::save(const QString &outFile)
+{
+	QMutexLocker lock(&m_lock);
+
+	QFile file(outFile);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Failed to open directory cache: %s", outFile.toUtf8().constData());
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_8);
+	stream << CACHE_MAGIC << CACHE_VERSION;
+
+	for(QHash<QString, listing_t>::ConstIterator iter = m_current.constBegin(); iter != m_current.constEnd(); iter++)
+	{
+		stream << RECORD_DIR << iter.key().toUtf8() << iter->mtime << iter->ctime << quint32(iter->entries.count());
+		for(QList<DirectoryWalker::entry_t>::ConstIterator entry = iter->entries.constBegin(); entry != iter->entries.constEnd(); entry++)
+		{
+			stream << entry->name.toUtf8() << entry->size << entry->mtime << entry->attributes;
+		}
+	}
+
+	stream << RECORD_EOF << quint64(m_current.count());
+
+	const bool okay = (stream.status() == QDataStream::Ok) && (file.error() == QFile::NoError);
+	file.close();
+
+	qDebug("Directory cache: %u directories reused, %u directories listed.", m_hitCount, m_missCount);
+	return okay;
+}
+
+void DirectoryCache::clear(void)
+{
+	QMutexLocker lock(&m_lock);
+
+	m_previous.clear();
+	m_current.clear();
+	m_hitCount = m_missCount = 0;
+}
+
+/*the previous listings are only read during a scan, so they can be looked up without locking*/
+bool DirectoryCache::lookup(const QString &directory, const qint64 &mtime, const qint64 &ctime, QList<DirectoryWalker::entry_t> &entries)
+{
+	QHash<QString, listing_t>::ConstIterator iter = m_previous.constFind(directory);
+	if((iter == m_previous.constEnd()) || (iter->mtime != mtime) || (iter->ctime != ctime))
+	{
+		return false;
+	}
+
+	/*reading the entries again would cost as much as listing the directory, so they are trusted*/
+	entries = iter->entries;
+
+	QMutexLocker lock(&m_lock);
+	m_current.insert(directory, iter.value());
+	m_hitCount++;
+
+	return true;
+}
+
+void DirectoryCache::update(const QString &directory, const qint64 &mtime, const qint64 &ctime, const QList<DirectoryWalker::entry_t> &entries)
+{
+	listing_t listing;
+	listing.mtime = mtime;
+	listing.ctime = ctime;
+	listing.entries = entries;
+
+	QMutexLocker lock(&m_lock);
+	m_current.insert(directory, listing);
+	m_missCount++;
+}
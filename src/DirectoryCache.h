@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+
+#include "DirectoryWalker.h"
+
+//=======================================================================================
+
+/*
+ * Keeps the entries of every scanned directory together with the directory's own time
+ * stamps. As long as both time stamps are unchanged, the next scan takes the entries
+ * from the cache instead of listing the directory again. The cached entries are trusted
+ * as they are: a file that is modified in place does not change the time stamps of its
+ * directory, so its new size and time stamp are only seen once the directory changes.
+ * Directories that are not seen during a scan are dropped from the cache when it is saved.
+ */
+
+class DirectoryCache
+{
+public:
+	DirectoryCache(void);
+	~DirectoryCache(void);
+
+	bool load(const QString &inFile);
+	bool save(const QString &outFile);
+	void clear(void);
+
+	bool lookup(const QString &directory, const qint64 &mtime, const qint64 &ctime, QList<DirectoryWalker::entry_t> &entries);
+	void update(const QString &directory, const qint64 &mtime, const qint64 &ctime, const QList<DirectoryWalker::entry_t> &entries);
+
+	quint32 hitCount(void) const { return m_hitCount; }
+	quint32 missCount(void) const { return m_missCount; }
+
+protected:
+	typedef struct
+	{
+		qint64 mtime;
+		qint64 ctime;
+		QList<DirectoryWalker::entry_t> entries;
+	}
+	listing_t;
+
+	QHash<QString, listing_t> m_previous;
+	QHash<QString, listing_t> m_current;
+	QMutex m_lock;
+
+	quint32 m_hitCount;
+	quint32 m_missCount;
+
+private:
+	DirectoryCache(const DirectoryCache&) : m_hitCount(0), m_missCount(0) {}
+	DirectoryCache &operator=(const DirectoryCache&) { return *this; }
+};
@@ -0,0 +1,278 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DirectoryTree.h"
+
+#include "Utilities.h"
+
+#include <QCryptographicHash>
+#include <QMap>
+
+//=======================================================================================
+// Utility Functions
+//=======================================================================================
+
+static inline QString PARENT_DIR(const QString &path)
+{
+	const int pos = path.lastIndexOf(QChar('/'));
+	if((pos < 0) || (pos == path.length() - 1))
+	{
+		return QString(); /*this is a drive root*/
+	}
+	return ((pos > 0) && (path.at(pos - 1) == QChar(':'))) ? path.left(pos + 1) : path.left(pos);
+}
+
+static inline QString BASE_NAME(const QString &path)
+{
+	return path.mid(path.lastIndexOf(QChar('/')) + 1);
+}
+
+static bool entryNameLessThan(const QPair<QString, QByteArray> &a, const QPair<QString, QByteArray> &b)
+{
+	return a.first.compare(b.first, Qt::CaseInsensitive) < 0;
+}
+
+static bool entryHashLessThan(const QPair<QString, QByteArray> &a, const QPair<QString, QByteArray> &b)
+{
+	return a.second < b.second;
+}
+
+static bool groupSizeGreaterThan(const DirectoryTree::group_t &a, const DirectoryTree::group_t &b)
+{
+	return (a.size != b.size) ? (a.size > b.size) : (a.hash < b.hash);
+}
+
+//=======================================================================================
+// Constructor & Destructor
+//=======================================================================================
+
+DirectoryTree::DirectoryTree(const QStringList &roots, const bool &contentOnly)
+:
+	m_contentOnly(contentOnly),
+	m_roots(roots)
+{
+}
+
+DirectoryTree::~DirectoryTree(void)
+{
+}
+
+//=======================================================================================
+// Public Functions
+//=======================================================================================
+
+void DirectoryTree::addFile(const QString &filePath, const QByteArray &hash, const qint64 &size)
+{
+	const QString dirPath = PARENT_DIR(filePath);
+	if(isInsideRoot(dirPath))
+	{
+		node_t &node = getNode(dirPath);
+		node.files << qMakePair(BASE_NAME(filePath), hash);
+		node.size += size;
+		node.fileCount++;
+	}
+}
+
+void DirectoryTree::addFailed(const QString &filePath)
+{
+	const QString dirPath = PARENT_DIR(filePath);
+	if(isInsideRoot(dirPath))
+	{
+		getNode(dirPath).complete = false;
+	}
+}
+
+void DirectoryTree::finish(void)
+{
+	m_groups.clear();
+	m_coveredBy.clear();
+
+	/*process the deepest directories first, so all children are done before their parent*/
+	QMultiMap<int, QString> depthMap;
+	for(QHash<QString, node_t>::ConstIterator iter = m_nodes.constBegin(); iter != m_nodes.constEnd(); iter++)
+	{
+		depthMap.insert(iter.key().count(QChar('/')) - (iter.key().endsWith(QChar('/')) ? 1 : 0), iter.key());
+	}
+
+	QHash<QByteArray, QStringList> directories;
+	QMapIterator<int, QString> iter(depthMap);
+	iter.toBack();
+
+	while(iter.hasPrevious())
+	{
+		iter.previous();
+		node_t &node = m_nodes[iter.value()];
+		node.hash = computeHash(node);
+
+		if(node.complete && (node.fileCount > 0))
+		{
+			directories[node.hash] << iter.value();
+		}
+
+		if(!node.parent.isEmpty())
+		{
+			node_t &parentNode = m_nodes[node.parent];
+			parentNode.subdirs << qMakePair(BASE_NAME(iter.value()), node.hash);
+			parentNode.size += node.size;
+			parentNode.fileCount += node.fileCount;
+			parentNode.complete = parentNode.complete && node.complete;
+		}
+	}
+
+	for(QHash<QByteArray, QStringList>::ConstIterator dirs = directories.constBegin(); dirs != directories.constEnd(); dirs++)
+	{
+		const QStringList &members = dirs.value();
+		if(members.count() < 2)
+		{
+			continue;
+		}
+
+		/*skip groups that are implied by an identical group of their parent directories*/
+		bool redundant = true;
+		QByteArray parentHash;
+		for(QStringList::ConstIterator dir = members.constBegin(); dir != members.constEnd(); dir++)
+		{
+			const QString &parent = m_nodes.value(*dir).parent;
+			if(parent.isEmpty() || (!m_nodes.value(parent).complete) || ((!parentHash.isEmpty()) && (parentHash != m_nodes.value(parent).hash)))
+			{
+				redundant = false;
+				break;
+			}
+			parentHash = m_nodes.value(parent).hash;
+		}
+		if(redundant && (directories.value(parentHash).count() == members.count()))
+		{
+			continue;
+		}
+
+		group_t group;
+		group.hash = dirs.key();
+		group.directories = members;
+		group.size = m_nodes.value(members.first()).size;
+		group.fileCount = m_nodes.value(members.first()).fileCount;
+		qSort(group.directories.begin(), group.directories.end(), Utilities::filePathLessThan);
+		m_groups << group;
+	}
+
+	qSort(m_groups.begin(), m_groups.end(), groupSizeGreaterThan);
+
+	for(int i = 0; i < m_groups.count(); i++)
+	{
+		for(QStringList::ConstIterator dir = m_groups[i].directories.constBegin(); dir != m_groups[i].directories.constEnd(); dir++)
+		{
+			m_coveredBy.insert(*dir, i);
+		}
+	}
+}
+
+/*
+ * Files that map to the same (non-empty) key are implied by one of the reported directory
+ * groups, so only one of them needs to be listed as an individual duplicate.
+ */
+QString DirectoryTree::coveringKey(const QString &filePath, const QByteArray &hash) const
+{
+	QString relativePath = BASE_NAME(filePath);
+	QString dirPath = PARENT_DIR(filePath);
+
+	while((!dirPath.isEmpty()) && isInsideRoot(dirPath))
+	{
+		if(m_coveredBy.contains(dirPath))
+		{
+			const QString suffix = m_contentOnly ? QString::fromLatin1(hash.toHex().constData()) : relativePath.toLower();
+			return QString("%1:%2").arg(QString::number(m_coveredBy.value(dirPath)), suffix);
+		}
+		relativePath = QString("%1/%2").arg(BASE_NAME(dirPath), relativePath);
+		dirPath = PARENT_DIR(dirPath);
+	}
+
+	return QString();
+}
+
+//=======================================================================================
+// Internal Functions
+//=======================================================================================
+
+bool DirectoryTree::isInsideRoot(const QString &path) const
+{
+	for(QStringList::ConstIterator root = m_roots.constBegin(); root != m_roots.constEnd(); root++)
+	{
+		if(path.compare(*root, Qt::CaseInsensitive) == 0)
+		{
+			return true;
+		}
+		if(path.startsWith(root->endsWith(QChar('/')) ? (*root) : QString("%1/").arg(*root), Qt::CaseInsensitive))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+DirectoryTree::node_t &DirectoryTree::getNode(const QString &path)
+{
+	if(!m_nodes.contains(path))
+	{
+		node_t node;
+		node.parent = PARENT_DIR(path);
+		node.size = 0;
+		node.fileCount = 0;
+		node.complete = true;
+
+		if(node.parent.isEmpty() || (!isInsideRoot(node.parent)))
+		{
+			node.parent.clear(); /*this is one of the scanned directories*/
+		}
+		else
+		{
+			getNode(node.parent);
+		}
+
+		m_nodes.insert(path, node);
+	}
+
+	return m_nodes[path];
+}
+
+QByteArray DirectoryTree::computeHash(node_t &node) const
+{
+	qSort(node.files.begin(), node.files.end(), m_contentOnly ? entryHashLessThan : entryNameLessThan);
+	qSort(node.subdirs.begin(), node.subdirs.end(), m_contentOnly ? entryHashLessThan : entryNameLessThan);
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	for(int k = 0; k < 2; k++)
+	{
+		const QList<QPair<QString, QByteArray> > &entries = k ? node.subdirs : node.files;
+		for(QList<QPair<QString, QByteArray> >::ConstIterator iter = entries.constBegin(); iter != entries.constEnd(); iter++)
+		{
+			hash.addData(k ? "D" : "F", 1);
+			if(!m_contentOnly)
+			{
+				hash.addData(iter->first.toLower().toUtf8());
+				hash.addData("", 1);
+			}
+			hash.addData(iter->second);
+		}
+	}
+
+	return hash.result();
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+//=======================================================================================
+
+/*
+ * Merkle tree over the scanned directories. The digest of a directory is computed bottom-up
+ * from the names and digests of its children, or from the child digests only when names
+ * are to be ignored. Directories with a file that could not be read are never reported.
+ */
+
+class DirectoryTree
+{
+public:
+	DirectoryTree(const QStringList &roots, const bool &contentOnly);
+	~DirectoryTree(void);
+
+	typedef struct
+	{
+		QByteArray hash;
+		QStringList directories;
+		qint64 size;
+		int fileCount;
+	}
+	group_t;
+
+	void addFile(const QString &filePath, const QByteArray &hash, const qint64 &size);
+	void addFailed(const QString &filePath);
+	void finish(void);
+
+	inline const QList<group_t> &groups(void) const { return m_groups; }
+	QString coveringKey(const QString &filePath, const QByteArray &hash) const;
+
+protected:
+	typedef struct
+	{
+		QString parent;
+		QList<QPair<QString, QByteArray> > files;
+		QList<QPair<QString, QByteArray> > subdirs;
+		QByteArray hash;
+		qint64 size;
+		int fileCount;
+		bool complete;
+	}
+	node_t;
+
+	bool isInsideRoot(const QString &path) const;
+	node_t &getNode(const QString &path);
+	QByteArray computeHash(node_t &node) const;
+
+	const bool m_contentOnly;
+	QStringList m_roots;
+
+	QHash<QString, node_t> m_nodes;
+	QHash<QString, int> m_coveredBy;
+	QList<group_t> m_groups;
+};
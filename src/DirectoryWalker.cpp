@@ -0,0 +1,179 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DirectoryWalker.h"
+
+#include "Config.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <QDir>
+
+/*not declared by the XP-compatible SDK headers*/
+#ifndef FIND_FIRST_EX_LARGE_FETCH
+#define FIND_FIRST_EX_LARGE_FETCH 0x00000002
+#endif
+static const FINDEX_INFO_LEVELS FIND_EX_INFO_BASIC = FINDEX_INFO_LEVELS(1);
+
+static const qint64 FILETIME_EPOCH_OFFSET = 116444736000000000i64;
+
+static inline qint64 FILETIME_TO_MSEC(const FILETIME &fileTime)
+{
+	const qint64 ticks = (qint64(fileTime.dwHighDateTime) << 32) | qint64(fileTime.dwLowDateTime);
+	return (ticks - FILETIME_EPOCH_OFFSET) / 10000i64;
+}
+
+static inline bool IS_DOT_ENTRY(const wchar_t *const name)
+{
+	return (name[0] == L'.') && ((name[1] == L'\0') || ((name[1] == L'.') && (name[2] == L'\0')));
+}
+
+//=======================================================================================
+// Directory Walker
+//=======================================================================================
+
+DirectoryWalker::DirectoryWalker(const QString &directory)
+:
+	m_handle(INVALID_HANDLE_VALUE),
+	m_findData(new WIN32_FIND_DATAW),
+	m_pending(false)
+{
+	const QString pattern = QDir::toNativeSeparators(directory.endsWith('/') ? (directory + '*') : (directory + "/*"));
+	WIN32_FIND_DATAW *const findData = static_cast<WIN32_FIND_DATAW*>(m_findData);
+
+	HANDLE handle = FindFirstFileExW((const wchar_t*)pattern.utf16(), FIND_EX_INFO_BASIC, findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if((handle == INVALID_HANDLE_VALUE) && (GetLastError() == ERROR_INVALID_PARAMETER))
+	{
+		/*basic info level and large fetch require Windows 7 or later*/
+		handle = FindFirstFileExW((const wchar_t*)pattern.utf16(), FindExInfoStandard, findData, FindExSearchNameMatch, NULL, 0);
+	}
+
+	m_handle = handle;
+	m_pending = (handle != INVALID_HANDLE_VALUE);
+}
+
+DirectoryWalker::~DirectoryWalker(void)
+{
+	if(m_handle != INVALID_HANDLE_VALUE)
+	{
+		FindClose(m_handle);
+	}
+
+	WIN32_FIND_DATAW *findData = static_cast<WIN32_FIND_DATAW*>(m_findData);
+	MY_DELETE(findData);
+}
+
+bool DirectoryWalker::isOpen(void) const
+{
+	return (m_handle != INVALID_HANDLE_VALUE);
+}
+
+bool DirectoryWalker::next(entry_t &entry)
+{
+	WIN32_FIND_DATAW *const findData = static_cast<WIN32_FIND_DATAW*>(m_findData);
+
+	while(m_pending)
+	{
+		/*skip system files and directories (e.g. "pagefile.sys" or "System Volume Information")*/
+		const bool skipEntry = IS_DOT_ENTRY(findData->cFileName) || ((findData->dwFileAttributes & FILE_ATTRIBUTE_SYSTEM) != 0);
+		if(!skipEntry)
+		{
+			entry.name = QString::fromUtf16((const ushort*)findData->cFileName);
+			entry.size = (qint64(findData->nFileSizeHigh) << 32) | qint64(findData->nFileSizeLow);
+			entry.mtime = FILETIME_TO_MSEC(findData->ftLastWriteTime);
+			entry.attributes = findData->dwFileAttributes;
+		}
+
+		m_pending = (FindNextFileW(m_handle, findData) != FALSE);
+
+		if(!skipEntry)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*the volume serial number and the file index identify a directory, regardless of the path it was reached by*/
+bool DirectoryWalker::identify(const QString &directory, quint32 &volume, quint64 &fileIndex, qint64 *const mtime, qint64 *const ctime)
+{
+	const QString nativePath = QDir::toNativeSeparators(directory);
+	const HANDLE handle = CreateFileW((const wchar_t*)nativePath.utf16(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+
+	if(handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	BY_HANDLE_FILE_INFORMATION info;
+	const bool okay = (GetFileInformationByHandle(handle, &info) != FALSE);
+	CloseHandle(handle);
+
+	if(okay)
+	{
+		volume = info.dwVolumeSerialNumber;
+		fileIndex = (quint64(info.nFileIndexHigh) << 32) | quint64(info.nFileIndexLow);
+		if(mtime)
+		{
+			*mtime = FILETIME_TO_MSEC(info.ftLastWriteTime);
+		}
+		if(ctime)
+		{
+			*ctime = FILETIME_TO_MSEC(info.ftCreationTime);
+		}
+	}
+
+	return okay;
+}
+
+/*returns the lower-case file system name (e.g. "ntfs") and drive type (e.g. "remote") of the volume containing the path*/
+bool DirectoryWalker::volumeType(const QString &path, QString &fileSystem, QString &driveType)
+{
+	const QString nativePath = QDir::toNativeSeparators(path);
+	wchar_t volumePath[MAX_PATH + 1], fileSystemName[MAX_PATH + 1];
+
+	if(!GetVolumePathNameW((const wchar_t*)nativePath.utf16(), volumePath, MAX_PATH + 1))
+	{
+		return false;
+	}
+
+	if(!GetVolumeInformationW(volumePath, NULL, 0, NULL, NULL, NULL, fileSystemName, MAX_PATH + 1))
+	{
+		return false;
+	}
+
+	fileSystem = QString::fromUtf16((const ushort*)fileSystemName).toLower();
+
+	switch(GetDriveTypeW(volumePath))
+	{
+		case DRIVE_REMOVABLE: driveType = QString::fromLatin1("removable"); break;
+		case DRIVE_FIXED:     driveType = QString::fromLatin1("fixed");     break;
+		case DRIVE_REMOTE:    driveType = QString::fromLatin1("remote");    break;
+		case DRIVE_CDROM:     driveType = QString::fromLatin1("cdrom");     break;
+		case DRIVE_RAMDISK:   driveType = QString::fromLatin1("ramdisk");   break;
+		default:              driveType = QString::fromLatin1("unknown");   break;
+	}
+
+	return true;
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+
+//=======================================================================================
+
+/*
+ * Lists the entries of a single directory via the native Win32 API. The entries are
+ * fetched in large batches and already carry their attributes, size and time stamp,
+ * so no additional per-file stat call is required while walking the directory tree.
+ * Entries with the "system" attribute are skipped, just like QDirIterator does.
+ */
+
+class DirectoryWalker
+{
+public:
+	typedef struct
+	{
+		QString name;
+		qint64 size;
+		qint64 mtime;  /*milliseconds since the epoch, UTC*/
+		quint32 attributes;
+	}
+	entry_t;
+
+	//Attribute flags
+	typedef enum
+	{
+		ATTRIBUTE_DIRECTORY     = 0x0010,
+		ATTRIBUTE_REPARSE_POINT = 0x0400
+	}
+	attribute_t;
+
+	DirectoryWalker(const QString &directory);
+	~DirectoryWalker(void);
+
+	bool isOpen(void) const;
+	bool next(entry_t &entry);
+
+	static bool identify(const QString &directory, quint32 &volume, quint64 &fileIndex, qint64 *const mtime = NULL, qint64 *const ctime = NULL);
+	static bool volumeType(const QString &path, QString &fileSystem, QString &driveType);
+
+	static inline bool isDirectory(const entry_t &entry) { return (entry.attributes & ATTRIBUTE_DIRECTORY)     != 0; }
+	static inline bool isLink(const entry_t &entry)      { return (entry.attributes & ATTRIBUTE_REPARSE_POINT) != 0; }
+
+protected:
+	void *m_handle;
+	void *m_findData;
+	bool m_pending;
+
+private:
+	DirectoryWalker(const DirectoryWalker&) : m_handle(NULL), m_findData(NULL), m_pending(false) {}
+	DirectoryWalker &operator=(const DirectoryWalker&) { return *this; }
+};
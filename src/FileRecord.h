@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+#include "Utilities.h"
+
+//=======================================================================================
+
+/*
+ * A file as found by the directory scanner. The metadata is taken from the directory
+ * entry, and all of the later stages use it instead of querying the file system again.
+ */
+
+typedef struct
+{
+	QString path;
+	qint64 size;
+	qint64 mtime;  /*milliseconds since the epoch, UTC*/
+	quint32 attributes;
+}
+fileRecord_t;
+
+/*
+ * A group of identical files, result models receive the duplicates in batches of these.
+ */
+
+typedef struct
+{
+	QByteArray hash;
+	QList<fileRecord_t> files;
+}
+duplicateGroup_t;
+
+static inline fileRecord_t MAKE_FILE_RECORD(const QString &path, const qint64 &size, const qint64 &mtime = 0, const quint32 &attributes = 0)
+{
+	fileRecord_t record;
+	record.path = path;
+	record.size = size;
+	record.mtime = mtime;
+	record.attributes = attributes;
+	return record;
+}
+
+static inline bool FILE_RECORD_LESS_THAN(const fileRecord_t &r1, const fileRecord_t &r2)
+{
+	return Utilities::filePathLessThan(r1.path, r2.path);
+}
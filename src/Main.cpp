@@ -34,6 +34,8 @@
 #include "System.h"
 #include "Taskbar.h"
 #include "Window_Main.h"
+#include "ShardWorker.h"
+#include "Model_Duplicates.h"
 
 //Initialize static Qt plugins
 #ifdef QT_NODLL
@@ -116,6 +118,28 @@ static int double_file_scanner(int argc, char* argv[])
 	//Create application
 	QApplication *application = init_qt(argc, argv);
 
+	//Run the result model benchmark instead of the GUI, if requested
+	for(int i = 1; i + 1 < argc; i++)
+	{
+		if(_stricmp(argv[i], "--benchmark-model") == 0)
+		{
+			DuplicatesModel::benchmark(qMax(1, atoi(argv[i + 1])));
+			delete application;
+			return EXIT_SUCCESS;
+		}
+	}
+
+	//Worker processes of a sharded scan run without any window
+	for(int i = 1; i < argc; i++)
+	{
+		if(_stricmp(argv[i], "--worker") == 0)
+		{
+			const int result = ShardWorker::run(application->arguments());
+			delete application;
+			return result;
+		}
+	}
+
 	//Initialize taskbar
 	Taskbar::init();
 
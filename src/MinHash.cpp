@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MinHash.h"
+
+static const quint32 EMPTY_BIN  = 0xFFFFFFFF;
+static const quint32 BIN_OFFSET = 0x9E3779B9;
+static const int     BIN_SHIFT  = 57; /*log2(NUM_BINS) upper bits select the bin*/
+
+static inline quint64 FMIX64(quint64 k)
+{
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDui64;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ui64;
+	k ^= k >> 33;
+	return k;
+}
+
+//=======================================================================================
+// Constructor & Destructor
+//=======================================================================================
+
+MinHash::MinHash(void)
+{
+	reset();
+}
+
+MinHash::~MinHash(void)
+{
+}
+
+//=======================================================================================
+// Public Functions
+//=======================================================================================
+
+void MinHash::reset(void)
+{
+	m_window = 0;
+	m_windowFill = 0;
+	m_signature.fill(EMPTY_BIN, NUM_BINS);
+}
+
+void MinHash::update(const char *data, const qint64 &len)
+{
+	quint32 *const bins = m_signature.data();
+	const quint8 *ptr = (const quint8*) data;
+	quint64 window = m_window;
+	qint64 pos = 0;
+
+	/*the window has to be filled up first*/
+	while((m_windowFill < SHINGLE_SIZE - 1) && (pos < len))
+	{
+		window = (window << 8) | ptr[pos++];
+		m_windowFill++;
+	}
+
+	while(pos < len)
+	{
+		window = (window << 8) | ptr[pos++];
+		const quint64 h = FMIX64(window);
+		const quint32 value = qMin(quint32(h), EMPTY_BIN - 1);
+		quint32 &bin = bins[h >> BIN_SHIFT];
+		if(value < bin)
+		{
+			bin = value;
+		}
+	}
+
+	m_window = window;
+}
+
+bool MinHash::finish(void)
+{
+	quint32 *const bins = m_signature.data();
+	int firstUsed = -1;
+
+	for(int i = 0; i < NUM_BINS; i++)
+	{
+		if(bins[i] != EMPTY_BIN)
+		{
+			firstUsed = i;
+			break;
+		}
+	}
+
+	if(firstUsed < 0)
+	{
+		return false; /*file is too short*/
+	}
+
+	/*rotation densification: empty bins borrow from the next non-empty bin to the right*/
+	quint32 borrowed = bins[firstUsed];
+	quint32 distance = 0;
+
+	for(int i = firstUsed + NUM_BINS - 1; i > firstUsed; i--)
+	{
+		quint32 &bin = bins[i % NUM_BINS];
+		if(bin == EMPTY_BIN)
+		{
+			bin = borrowed + ((++distance) * BIN_OFFSET);
+		}
+		else
+		{
+			borrowed = bin;
+			distance = 0;
+		}
+	}
+
+	return true;
+}
+
+int MinHash::similarity(const QVector<quint32> &sig1, const QVector<quint32> &sig2)
+{
+	if((sig1.count() != NUM_BINS) || (sig2.count() != NUM_BINS))
+	{
+		return 0;
+	}
+
+	int matches = 0;
+	for(int i = 0; i < NUM_BINS; i++)
+	{
+		if(sig1[i] == sig2[i])
+		{
+			matches++;
+		}
+	}
+
+	return (matches * 100) / NUM_BINS;
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QVector>
+
+//=======================================================================================
+
+/*
+ * MinHash sketch of the byte shingles of a file. Uses "one permutation hashing", i.e. a
+ * single hash function whose range is partitioned into NUM_BINS bins, so each shingle
+ * costs one hash evaluation only. Empty bins are filled by rotation densification.
+ */
+
+class MinHash
+{
+public:
+	MinHash(void);
+	~MinHash(void);
+
+	static const int NUM_BINS = 128;
+	static const int SHINGLE_SIZE = 8;
+
+	void reset(void);
+	void update(const char *data, const qint64 &len);
+	bool finish(void);
+
+	inline const QVector<quint32> &signature(void) const { return m_signature; }
+	static int similarity(const QVector<quint32> &sig1, const QVector<quint32> &sig2);
+
+protected:
+	quint64 m_window;
+	int m_windowFill;
+	QVector<quint32> m_signature;
+};
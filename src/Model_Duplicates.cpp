@@ -26,17 +26,31 @@
 #include <QIcon>
 #include <QDir>
 #include <QSettings>
+#include <QSet>
 #include <QXmlStreamWriter>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QThread>
 
 #include "Config.h"
 #include "Utilities.h"
 #include "System.h"
+#include "ArchiveReader.h"
 
 #include <cassert>
+#include <algorithm>
+#include <iterator>
 
 static const QString EMPTY_STRING;
 static const QByteArray EMPTY_BYTEARRAY;
 static const qint64 ZERO_SIZE = 0;
+static const int DIGEST_SIZE = 20;
+static const int DISPLAY_CACHE_SIZE = 4096;
+static const int FETCH_PAGE_SIZE = 1024;
+static const int PARALLEL_SORT_MIN = 65536;
+static const quint8 REMOVED_GROUP = 0xFF;
 
 static inline QString LIMIT_STR(const QString &str, const int maxLen)
 {
@@ -61,128 +75,140 @@ static inline QString FORMAT_NUMBER(qint64 value)
 	return formated;
 }
 
-//===================================================================
-// Duplicates Items
-//===================================================================
+static inline QString FILE_NAME(const QString &filePath)
+{
+	return filePath.mid(filePath.lastIndexOf('/') + 1);
+}
 
-enum
+static inline QString PARENT_PATH(const QString &filePath)
 {
-	ITEM_ROOT  = 0,
-	ITEM_GROUP = 1,
-	ITEM_FILE  = 2
+	const int pos = filePath.lastIndexOf('/');
+	return ((pos > 0) && (filePath.at(pos - 1) != QLatin1Char(':'))) ? filePath.left(pos) : filePath.left(pos + 1);
 }
-ItemType_t;
 
-class DuplicateItem
+static inline QString CHANGE_LABEL(const int &changeType)
 {
-public:
-	DuplicateItem(DuplicateItem *const parent = NULL)
-	:
-		m_parent(parent)
+	switch(changeType)
 	{
-		if(parent)
-		{
-			parent->addChild(this);
-		}
+		case ResultStore::CHANGE_NEW:      return DuplicatesModel::tr("[New] ");
+		case ResultStore::CHANGE_GROWN:    return DuplicatesModel::tr("[Grown] ");
+		case ResultStore::CHANGE_CHANGED:  return DuplicatesModel::tr("[Changed] ");
+		case ResultStore::CHANGE_RESOLVED: return DuplicatesModel::tr("[Resolved] ");
 	}
+	return QString();
+}
 
-	virtual ~DuplicateItem(void)
-	{
-		removeAllChilderen();
-	}
+//===================================================================
+// Parallel Sort
+//===================================================================
 
-	inline DuplicateItem *child(const int index) const { return m_childeren[index]; }
-	inline int childCount(void) const { return m_childeren.count(); }
-	inline void addChild(DuplicateItem *child) { m_childeren << child; }
-	inline int row(void) { return m_parent ? m_parent->m_childeren.indexOf(this) : 0; }
-	inline DuplicateItem *parent(void) const { return m_parent; }
+typedef struct
+{
+	qint64 key;
+	quint32 group;
+}
+sortEntry_t;
 
-	void removeAllChilderen(void)
-	{
-		while(!m_childeren.isEmpty())
-		{
-			DuplicateItem *child = m_childeren.takeLast();
-			MY_DELETE(child);
-		}
-	}
+typedef struct
+{
+	QString path;
+	quint32 group;
+}
+pathEntry_t;
 
-	void removeChild(DuplicateItem *const child)
-	{
-		m_childeren.removeAll(child);
-		delete child;
-	}
+static inline quint64 TRIGRAM_KEY(const QChar *const str)
+{
+	return (quint64(str[0].unicode()) << 32) | (quint64(str[1].unicode()) << 16) | quint64(str[2].unicode());
+}
 
-	virtual int type(void)
-	{
-		return ITEM_ROOT;
-	}
+static inline bool POSTING_LESS_THAN(const QVector<quint32> *const list1, const QVector<quint32> *const list2)
+{
+	return list1->count() < list2->count();
+}
 
-protected:
-	DuplicateItem *const m_parent;
-	QList<DuplicateItem*> m_childeren;
+static inline bool SORT_ENTRY_LESS_THAN(const sortEntry_t &e1, const sortEntry_t &e2)
+{
+	return (e1.key < e2.key) || ((e1.key == e2.key) && (e1.group < e2.group));
+}
 
-private:
-	DuplicateItem &operator=(const DuplicateItem&)
-	{
-		throw std::runtime_error("Unimplemented");
-	}
-};
+static inline bool PATH_ENTRY_LESS_THAN(const pathEntry_t &e1, const pathEntry_t &e2)
+{
+	return Utilities::filePathLessThan(e1.path, e2.path);
+}
 
-class DuplicateItem_Group : public DuplicateItem
+template<typename T, typename LessThan>
+class SortTask : public QRunnable
 {
 public:
-	DuplicateItem_Group(DuplicateItem *const parent, const QByteArray &hash)
-	:
-		DuplicateItem(parent),
-		m_hash(hash)
-	{
-		/*nithing to do here*/
-	}
-
-	virtual int type(void)
-	{
-		return ITEM_GROUP;
-	}
-
-	inline const QByteArray &getHash(void) const { return m_hash; }
+	SortTask(T *const begin, T *const end, LessThan lessThan) : m_begin(begin), m_end(end), m_lessThan(lessThan) { }
+	virtual void run(void) { qSort(m_begin, m_end, m_lessThan); }
 
 protected:
-	const QByteArray m_hash;
+	T *const m_begin;
+	T *const m_end;
+	LessThan m_lessThan;
 };
 
-class DuplicateItem_File : public DuplicateItem
+/*sorts equal slices on all cores, then merges neighboring slices until a single one is left*/
+template<typename T, typename LessThan>
+static void PARALLEL_SORT(QVector<T> &data, LessThan lessThan)
 {
-public:
-	DuplicateItem_File(DuplicateItem *const parent, const QString &filePath, const qint64 &fileSize)
-	:
-		DuplicateItem(parent),
-		m_fileInfo(filePath),
-		m_fileSize(fileSize)
+	const int sliceCount = qBound(1, QThread::idealThreadCount(), 32);
+	if((sliceCount < 2) || (data.count() < PARALLEL_SORT_MIN))
 	{
-		/*nithing to do here*/
+		qSort(data.begin(), data.end(), lessThan);
+		return;
 	}
 
-	virtual int type(void)
+	T *const base = data.data();
+	QVector<int> bounds;
+	for(int i = 0; i <= sliceCount; i++)
 	{
-		return ITEM_FILE;
+		bounds << int((qint64(data.count()) * i) / sliceCount);
 	}
 
-	inline const QString getName(void) const         { return m_fileInfo.fileName();         }
-	inline const QString getPath(void) const         { return m_fileInfo.absolutePath();     }
-	inline const QString getFilePath(void) const     { return m_fileInfo.absoluteFilePath(); }
-	inline void setFilePath(const QString &filePath) { m_fileInfo.setFile(filePath);         }
-	inline const qint64 &getFileSize(void) const     { return m_fileSize;                    }
+	QThreadPool pool;
+	pool.setMaxThreadCount(sliceCount);
+	for(int i = 0; i < sliceCount; i++)
+	{
+		pool.start(new SortTask<T, LessThan>(base + bounds.at(i), base + bounds.at(i + 1), lessThan));
+	}
+	pool.waitForDone();
 
-protected:
-	QFileInfo m_fileInfo;
-	const qint64 m_fileSize;
-};
+	while(bounds.count() > 2)
+	{
+		QVector<int> merged;
+		for(int i = 0; i < bounds.count() - 1; i += 2)
+		{
+			merged << bounds.at(i);
+			if(i + 2 < bounds.count())
+			{
+				std::inplace_merge(base + bounds.at(i), base + bounds.at(i + 1), base + bounds.at(i + 2), lessThan);
+			}
+		}
+		merged << bounds.last();
+		bounds.swap(merged);
+	}
+}
 
 //===================================================================
 // Constructor & Destructor
 //===================================================================
 
 DuplicatesModel::DuplicatesModel(void)
+:
+	m_deadFiles(0),
+	m_fetchedGroups(0),
+	m_sortKey(SORT_DEFAULT),
+	m_sortOrder(Qt::AscendingOrder),
+	m_filterMinSize(-1),
+	m_filterMaxSize(-1),
+	m_orderDirty(false),
+	m_pathIndexed(false),
+	m_generation(1),
+	m_cacheKey(DISPLAY_CACHE_SIZE, 0),
+	m_cacheGeneration(DISPLAY_CACHE_SIZE, 0),
+	m_cacheText(DISPLAY_CACHE_SIZE)
 {
 	m_iconDflt = new QIcon(":/res/Icon_Bullet.png");
 	m_iconDupl = new QIcon(":/res/Icon_Duplicate.png");
@@ -193,13 +219,10 @@ DuplicatesModel::DuplicatesModel(void)
 	m_fontBold = new QFont("Monospace");
 	m_fontBold->setStyleHint(QFont::TypeWriter);
 	m_fontBold->setBold(true);
-
-	m_root = new DuplicateItem();
 }
 
 DuplicatesModel::~DuplicatesModel(void)
 {
-	MY_DELETE(m_root);
 	MY_DELETE(m_fontDflt);
 	MY_DELETE(m_fontBold);
 	MY_DELETE(m_iconDflt);
@@ -210,17 +233,29 @@ DuplicatesModel::~DuplicatesModel(void)
 // Model Functions
 //===================================================================
 
+/*
+ * Group rows have the internal id zero, file rows have the id of their group plus one.
+ * Group ids stay the same until the model is cleared, even if the rows of the groups move.
+ */
 QModelIndex DuplicatesModel::index(int row, int column, const QModelIndex &parent) const
 {
-	DuplicateItem *parentItem = m_root;
-	if(parent.isValid() && parent.internalPointer())
-	{
-		parentItem = static_cast<DuplicateItem*>(parent.internalPointer());
-	}
-
-	if(parentItem && (row >= 0) && (row < parentItem->childCount()))
+	if(row >= 0)
 	{
-		return createIndex(row, column, parentItem->child(row));
+		if(!parent.isValid())
+		{
+			if(row < m_fetchedGroups)
+			{
+				return createIndex(row, column, quint32(0));
+			}
+		}
+		else
+		{
+			const int group = groupOf(parent);
+			if((group >= 0) && (row < int(m_groupSize.at(group))))
+			{
+				return createIndex(row, column, quint32(group + 1));
+			}
+		}
 	}
 
 	return QModelIndex();
@@ -228,16 +263,13 @@ QModelIndex DuplicatesModel::index(int row, int column, const QModelIndex &paren
 
 QModelIndex DuplicatesModel::parent(const QModelIndex &index) const
 {
-	DuplicateItem *item = m_root;
-	if(index.isValid() && index.internalPointer())
-	{
-		item = static_cast<DuplicateItem*>(index.internalPointer());
-	}
-
-	DuplicateItem *parentItem = item->parent();
-	if(parentItem && (parentItem != m_root))
+	if(index.isValid() && (index.internalId() > 0) && (index.internalId() <= m_groupRow.count()))
 	{
-		return createIndex(parentItem->row(), 0, parentItem);
+		const int row = m_groupRow.at(int(index.internalId() - 1));
+		if(row >= 0)
+		{
+			return createIndex(row, 0, quint32(0));
+		}
 	}
 
 	return QModelIndex();
@@ -245,13 +277,13 @@ QModelIndex DuplicatesModel::parent(const QModelIndex &index) const
 
 int DuplicatesModel::rowCount(const QModelIndex &parent) const
 {
-	DuplicateItem *item = m_root;
-	if(parent.isValid() && parent.internalPointer())
+	if(!parent.isValid())
 	{
-		item = static_cast<DuplicateItem*>(parent.internalPointer());
+		return m_fetchedGroups;
 	}
 
-	return item->childCount();
+	const int group = groupOf(parent);
+	return (group >= 0) ? int(m_groupSize.at(group)) : 0;
 }
 
 int DuplicatesModel::columnCount(const QModelIndex &parent) const
@@ -259,51 +291,95 @@ int DuplicatesModel::columnCount(const QModelIndex &parent) const
 	return 3;
 }
 
+/*groups are handed to the view one page at a time, while the view is scrolled down*/
+bool DuplicatesModel::canFetchMore(const QModelIndex &parent) const
+{
+	return (!parent.isValid()) && (m_fetchedGroups < m_groupOrder.count());
+}
+
+void DuplicatesModel::fetchMore(const QModelIndex &parent)
+{
+	if(canFetchMore(parent))
+	{
+		const int count = qMin(m_groupOrder.count() - m_fetchedGroups, FETCH_PAGE_SIZE);
+		beginInsertRows(QModelIndex(), m_fetchedGroups, m_fetchedGroups + count - 1);
+		m_fetchedGroups += count;
+		endInsertRows();
+	}
+}
+
+/*the internal id tells groups and files apart, so the roles that don't depend on the row need no lookup*/
 QVariant DuplicatesModel::data(const QModelIndex &index, int role) const
 {
-	DuplicateItem *item = m_root;
-	if(index.isValid() && index.internalPointer())
+	if(!index.isValid())
 	{
-		item = static_cast<DuplicateItem*>(index.internalPointer());
+		return QVariant();
 	}
 
+	const bool isGroup = (index.internalId() == 0);
+
 	switch(role)
 	{
 	/* ============= DISPLAY ROLE ============= */
 	case Qt::DisplayRole:
-		if(DuplicateItem_File *file = dynamic_cast<DuplicateItem_File*>(item))
-		{
-			switch(index.column())
-			{
-				case 0: return LIMIT_STR(file->getName(), 32);
-				case 1: return QDir::toNativeSeparators(file->getPath());
-				case 2: return Utilities::sizeToString(file->getFileSize());
-			}
-		}
-		else if(DuplicateItem_Group *group = dynamic_cast<DuplicateItem_Group*>(item))
+		if(isGroup ? (index.column() == 0) : (index.column() < 3))
 		{
-			if(index.column() == 0)
+			const int group = isGroup ? groupOf(index) : -1;
+			const int slot = isGroup ? -1 : slotOf(index);
+			if((group >= 0) || (slot >= 0))
 			{
-				return QString().sprintf("%.16s (%c%d)", group->getHash().toHex().constData(), ushort(0xd7), group->childCount());
+				return displayText(group, slot, index.column());
 			}
 		}
 		break;
 	/* ============= TOOL-TIP ROLE ============= */
 	case Qt::ToolTipRole:
-		if(DuplicateItem_File *file = dynamic_cast<DuplicateItem_File*>(item))
+		if(isGroup)
 		{
-			return (index.column() < 2) ? QDir::toNativeSeparators(file->getFilePath()) : tr("%1 Bytes").arg(FORMAT_NUMBER(file->getFileSize()));
+			const int group = groupOf(index);
+			if(group < 0)
+			{
+				break;
+			}
+			if(m_groupType.at(group) == GROUP_OVERLAP)
+			{
+				return tr("Partial Overlap: each file shares at least %1 Bytes with another one").arg(FORMAT_NUMBER(m_groupScore.at(group)));
+			}
+			if(m_groupType.at(group) == GROUP_SIMILAR)
+			{
+				return tr("Similar Content: at least %1% estimated similarity").arg(QString::number(m_groupScore.at(group)));
+			}
+			if(m_groupType.at(group) == GROUP_DIRECTORY)
+			{
+				return QString().sprintf("Directory Digest: %s", groupDigest(group).toHex().constData());
+			}
+			return CHANGE_LABEL(m_groupChange.at(group)) + QString().sprintf("SHA-1 Digest: %s", groupDigest(group).toHex().constData());
 		}
-		else if(DuplicateItem_Group *group = dynamic_cast<DuplicateItem_Group*>(item))
+		else
 		{
-			return QString().sprintf("SHA-1 Digest: %s", group->getHash().toHex().constData());
+			const int slot = slotOf(index);
+			if(slot < 0)
+			{
+				break;
+			}
+			if(index.column() < 2)
+			{
+				if(m_fileChange.at(slot) == ResultStore::CHANGE_NEW)      return tr("%1 (added since the previous run)").arg(QDir::toNativeSeparators(m_filePath.at(slot)));
+				if(m_fileChange.at(slot) == ResultStore::CHANGE_RESOLVED) return tr("%1 (removed since the previous run)").arg(QDir::toNativeSeparators(m_filePath.at(slot)));
+				return QDir::toNativeSeparators(m_filePath.at(slot));
+			}
+			if(m_fileModified.at(slot) > 0)
+			{
+				return tr("%1 Bytes, last modified: %2").arg(FORMAT_NUMBER(m_fileSize.at(slot)), QDateTime::fromMSecsSinceEpoch(m_fileModified.at(slot)).toString(Qt::SystemLocaleShortDate));
+			}
+			return tr("%1 Bytes").arg(FORMAT_NUMBER(m_fileSize.at(slot)));
 		}
 		break;
 	/* ============= DECORATION ROLE ============= */
 	case Qt::DecorationRole:
 		if(index.column() == 0)
 		{
-			return (item->type() == ITEM_GROUP) ? (*m_iconDupl) : (*m_iconDflt);
+			return isGroup ? (*m_iconDupl) : (*m_iconDflt);
 		}
 		break;
 	/* ============= TEXT-ALIGNMENT ROLE ============= */
@@ -315,7 +391,15 @@ QVariant DuplicatesModel::data(const QModelIndex &index, int role) const
 		break;
 	/* ============= FONT ROLE ============= */
 	case Qt::FontRole:
-		return (item->type() == ITEM_GROUP) ? (*m_fontBold) : (*m_fontDflt);
+		if((!isGroup) && (!m_filterText.isEmpty()))
+		{
+			const int slot = slotOf(index);
+			if((slot >= 0) && m_fileMatch.testBit(slot))
+			{
+				return (*m_fontBold); /*highlight the matching files within the shown groups*/
+			}
+		}
+		return isGroup ? (*m_fontBold) : (*m_fontDflt);
 	}
 
 	return QVariant();
@@ -349,96 +433,132 @@ QVariant DuplicatesModel::headerData(int section, Qt::Orientation orientation, i
 
 unsigned int DuplicatesModel::duplicateCount(void) const
 {
-	return m_root->childCount();
+	return groupCount(GROUP_DUPLICATE);
 }
 
-unsigned int DuplicatesModel::duplicateFileCount(const QModelIndex &index) const
+/*the counts and the duplicate groups always cover all groups, regardless of the current filter*/
+unsigned int DuplicatesModel::groupCount(const int &groupType) const
 {
-	if(index.isValid())
+	unsigned int count = 0;
+	for(QVector<quint8>::ConstIterator iter = m_groupType.constBegin(); iter != m_groupType.constEnd(); iter++)
 	{
-		if(DuplicateItem *currentItem = static_cast<DuplicateItem*>(index.internalPointer()))
+		if((*iter) == groupType)
 		{
-			if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentItem))
-			{
-				if(DuplicateItem_Group *duplicateGroup = dynamic_cast<DuplicateItem_Group*>(currentFile->parent()))
-				{
-					return duplicateGroup->childCount();
-				}
-			}
+			count++;
 		}
 	}
-	
-	return 0;
+	return count;
 }
 
-const QString DuplicatesModel::getFilePath(const QModelIndex &index) const
+unsigned int DuplicatesModel::changeCount(const int &changeType) const
 {
-	if(index.isValid())
+	unsigned int count = 0;
+	for(int group = 0; group < m_groupChange.count(); group++)
 	{
-		if(DuplicateItem *currentItem = static_cast<DuplicateItem*>(index.internalPointer()))
+		if((m_groupType.at(group) != REMOVED_GROUP) && (m_groupChange.at(group) == changeType))
 		{
-			if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentItem))
-			{
-				return currentFile->getFilePath();
-			}
+			count++;
 		}
 	}
-	
-	return EMPTY_STRING;
+	return count;
 }
 
-const qint64 &DuplicatesModel::getFileSize(const QModelIndex &index) const
+QList<ResultStore::group_t> DuplicatesModel::duplicateGroups(void) const
 {
-	if(index.isValid())
+	QList<ResultStore::group_t> groups;
+
+	for(int id = 0; id < m_groupType.count(); id++)
 	{
-		if(DuplicateItem *currentItem = static_cast<DuplicateItem*>(index.internalPointer()))
+		if((m_groupType.at(id) != GROUP_DUPLICATE) || (m_groupChange.at(id) == ResultStore::CHANGE_RESOLVED))
 		{
-			if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentItem))
+			continue;
+		}
+		ResultStore::group_t group;
+		group.hash = groupDigest(id);
+		group.size = 0;
+		const int first = int(m_groupFirst.at(id)), last = first + int(m_groupSize.at(id));
+		for(int slot = first; slot < last; slot++)
+		{
+			if(m_fileChange.at(slot) != ResultStore::CHANGE_RESOLVED)
 			{
-				return currentFile->getFileSize();
+				group.size = m_fileSize.at(slot);
+				group.files << m_filePath.at(slot);
 			}
 		}
+		if(!group.files.isEmpty())
+		{
+			groups << group;
+		}
 	}
 
-	return ZERO_SIZE;
+	return groups;
 }
 
-const QByteArray &DuplicatesModel::getGroupHash(const QModelIndex &index) const
+int DuplicatesModel::getGroupType(const QModelIndex &index) const
 {
-	if(index.isValid())
+	const int group = groupOf(index);
+	return (group >= 0) ? int(m_groupType.at(group)) : -1;
+}
+
+unsigned int DuplicatesModel::duplicateFileCount(const QModelIndex &index) const
+{
+	if(slotOf(index) >= 0)
 	{
-		if(DuplicateItem *currentItem = static_cast<DuplicateItem*>(index.internalPointer()))
-		{
-			if(DuplicateItem_Group *currentGroup = dynamic_cast<DuplicateItem_Group*>(currentItem))
-			{
-				return currentGroup->getHash();
-			}
-		}
+		return m_groupSize.at(int(index.internalId() - 1));
 	}
+	
+	return 0;
+}
+
+const QString DuplicatesModel::getFilePath(const QModelIndex &index) const
+{
+	const int slot = slotOf(index);
+	return (slot >= 0) ? m_filePath.at(slot) : EMPTY_STRING;
+}
+
+const qint64 &DuplicatesModel::getFileSize(const QModelIndex &index) const
+{
+	const int slot = slotOf(index);
+	return (slot >= 0) ? m_fileSize.at(slot) : ZERO_SIZE;
+}
 
-	return EMPTY_BYTEARRAY;
+QByteArray DuplicatesModel::getGroupHash(const QModelIndex &index) const
+{
+	const int group = groupOf(index);
+	return (group >= 0) ? groupDigest(group) : EMPTY_BYTEARRAY;
 }
 
 QString DuplicatesModel::toString(void)
 {
 	QStringList lines;
-	const int hashCount = m_root->childCount();
 
-	for(int i = 0; i < hashCount; i++)
+	for(QVector<quint32>::ConstIterator iter = m_groupOrder.constBegin(); iter != m_groupOrder.constEnd(); iter++)
 	{
-		if(DuplicateItem_Group *currentGroup = dynamic_cast<DuplicateItem_Group*>(m_root->child(i)))
+		if(m_groupType.at(*iter) == GROUP_OVERLAP)
 		{
-			lines << QString::fromLatin1(currentGroup->getHash().toHex().constData());
-			const int fileCount = currentGroup->childCount();
-
-			for(int j = 0; j < fileCount; j++)
-			{
-				DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentGroup->child(j));
-				lines << QString("- %1").arg(QDir::toNativeSeparators(currentFile->getFilePath()));
-			}
+			lines << tr("Overlap: %1 Bytes shared").arg(FORMAT_NUMBER(m_groupScore.at(*iter)));
+		}
+		else if(m_groupType.at(*iter) == GROUP_SIMILAR)
+		{
+			lines << tr("Similar: %1%").arg(QString::number(m_groupScore.at(*iter)));
+		}
+		else if(m_groupType.at(*iter) == GROUP_DIRECTORY)
+		{
+			lines << tr("Directory: %1").arg(QString::fromLatin1(groupDigest(*iter).toHex().constData()));
+		}
+		else
+		{
+			lines << CHANGE_LABEL(m_groupChange.at(*iter)) + QString::fromLatin1(groupDigest(*iter).toHex().constData());
+		}
 
-			lines << QString();
+		const int first = int(m_groupFirst.at(*iter)), last = first + int(m_groupSize.at(*iter));
+		for(int slot = first; slot < last; slot++)
+		{
+			const QString suffix = (m_fileChange.at(slot) == ResultStore::CHANGE_NEW) ? tr(" (added)") : ((m_fileChange.at(slot) == ResultStore::CHANGE_RESOLVED) ? tr(" (removed)") : QString());
+			lines << QString("- %1%2").arg(QDir::toNativeSeparators(m_filePath.at(slot)), suffix);
 		}
+
+		lines << QString();
 	}
 
 	return lines.join("\r\n");
@@ -451,207 +571,920 @@ QString DuplicatesModel::toString(void)
 void DuplicatesModel::clear(void)
 {
 	beginResetModel();
-	m_root->removeAllChilderen();
+
+	m_groupFirst.clear();
+	m_groupSize.clear();
+	m_groupScore.clear();
+	m_groupType.clear();
+	m_groupChange.clear();
+	m_groupDigest.clear();
+	m_groupOrder.clear();
+	m_groupRow.clear();
+
+	m_filePath.clear();
+	m_fileSize.clear();
+	m_fileModified.clear();
+	m_fileChange.clear();
+	m_fileMatch.clear();
+	m_deadFiles = 0;
+	m_fetchedGroups = 0;
+	m_generation++;
+
+	m_pathRank.clear();
+	m_pathIndex.clear();
+	m_pathIndexed = false;
+	m_filterText.clear();
+	m_filterMinSize = m_filterMaxSize = -1;
+	m_orderDirty = false;
+
 	endResetModel();
 }
 
-void DuplicatesModel::addDuplicate(const QByteArray &hash, const QStringList &files, const qint64 &size)
+/*a whole batch of groups is inserted with a single notification of the view*/
+void DuplicatesModel::addDuplicates(const QList<duplicateGroup_t> &groups)
 {
-	if(!files.isEmpty())
+	int count = 0;
+	for(QList<duplicateGroup_t>::ConstIterator iter = groups.constBegin(); iter != groups.constEnd(); iter++)
 	{
-		beginInsertRows(QModelIndex(), m_root->childCount(), m_root->childCount());
-		DuplicateItem_Group *group = new DuplicateItem_Group(m_root, hash);
-		for(QStringList::ConstIterator iterFile = files.constBegin(); iterFile != files.constEnd(); iterFile++)
+		if(!iter->files.isEmpty())
 		{
-			new DuplicateItem_File(group, (*iterFile), size);
+			count++;
 		}
-		endInsertRows();
 	}
-}
 
-bool DuplicatesModel::renameFile(const QModelIndex &index, const QString &newFileName)
-{
-	if(index.isValid())
+	const int visible = beginAppendGroups(count);
+	for(QList<duplicateGroup_t>::ConstIterator iter = groups.constBegin(); iter != groups.constEnd(); iter++)
 	{
-		if(DuplicateItem *currentItem = static_cast<DuplicateItem*>(index.internalPointer()))
+		if(!iter->files.isEmpty())
 		{
-			if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentItem))
+			appendGroup(iter->hash);
+			for(QList<fileRecord_t>::ConstIterator iterFile = iter->files.constBegin(); iterFile != iter->files.constEnd(); iterFile++)
 			{
-				const QString oldFilePath = currentFile->getFilePath();
-				if(QFileInfo(oldFilePath).exists() && QFileInfo(oldFilePath).isFile())
-				{
-					QString newFilePath = QString("%1/%2").arg(QFileInfo(oldFilePath).absolutePath(), newFileName);
-					if(oldFilePath.compare(newFilePath, Qt::CaseInsensitive) == 0)
-					{
-						return true; /*no need to rename*/
-					}
-					if(QFileInfo(newFilePath).exists())
-					{
-						const QString suffix   = QFileInfo(newFilePath).suffix();
-						const QString baseName = QFileInfo(newFilePath).completeBaseName();
-						const QString path     = QFileInfo(newFilePath).absolutePath();
-						for(int n = 2; QFileInfo(newFilePath).exists(); n++)
-						{
-							newFilePath = QString("%1/%2 (%3).%4").arg(path, baseName, QString::number(n), suffix);
-							if(n > SHRT_MAX) return false;
-						}
-					}
-					if(QFile::rename(oldFilePath, newFilePath))
-					{
-						currentFile->setFilePath(newFilePath);
-						emit dataChanged(index, index);
-						return true;
-					}
-				}
+				appendFile(iterFile->path, iterFile->size, iterFile->mtime);
 			}
 		}
 	}
-
-	return false;
+	endAppendGroups(visible);
 }
 
-bool DuplicatesModel::deleteFile(const QModelIndex &index)
+void DuplicatesModel::addOverlap(const QStringList &files, const QList<qint64> &sizes, const qint64 &sharedBytes)
 {
-	if(index.isValid())
+	if((!files.isEmpty()) && (files.count() == sizes.count()))
 	{
-		if(DuplicateItem *currentItem = static_cast<DuplicateItem*>(index.internalPointer()))
+		const int visible = beginAppendGroups(1);
+		appendGroup(QByteArray(), GROUP_OVERLAP, sharedBytes);
+		for(int i = 0; i < files.count(); i++)
 		{
-			if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentItem))
-			{
-				const QString oldFilePath = currentFile->getFilePath();
-				bool okay = true;
-				if(QFileInfo(oldFilePath).exists() && QFileInfo(oldFilePath).isFile())
-				{
-					okay = QFile::remove(currentFile->getFilePath());
-					if(!okay)
-					{
-						QFile::setPermissions(currentFile->getFilePath(), QFile::ReadUser | QFile::WriteUser);
-						okay = QFile::remove(currentFile->getFilePath());
-					}
-				}
-				if(okay)
-				{
-					if(DuplicateItem *parentItem = currentFile->parent())
-					{
-						beginRemoveRows(parent(index), index.row(), index.row());
-						parentItem->removeChild(currentFile);
-						endRemoveRows();
-					}
-				}
-				return okay;
-			}
+			appendFile(files.at(i), sizes.at(i));
 		}
+		endAppendGroups(visible);
 	}
-
-	return false;
 }
 
-//===================================================================
-// Export Functions
-//===================================================================
-
-bool DuplicatesModel::exportToFile(const QString &outFile, const int &format)
+void DuplicatesModel::addSimilar(const QStringList &files, const QList<qint64> &sizes, const int &similarity)
 {
-	switch(format)
+	if((!files.isEmpty()) && (files.count() == sizes.count()))
 	{
-	case FORMAT_INI:
-		return exportToIni(outFile);
-		break;
-	case FORMAT_XML:
-		return exportToXml(outFile);
-		break;
+		const int visible = beginAppendGroups(1);
+		appendGroup(QByteArray(), GROUP_SIMILAR, similarity);
+		for(int i = 0; i < files.count(); i++)
+		{
+			appendFile(files.at(i), sizes.at(i));
+		}
+		endAppendGroups(visible);
 	}
-
-	return false;
 }
 
-bool DuplicatesModel::exportToIni(const QString &outFile)
+void DuplicatesModel::addDirectory(const QByteArray &hash, const QStringList &directories, const qint64 &size, const int &fileCount)
 {
-	QSettings settings(outFile, QSettings::IniFormat);
-	const int groupCount = m_root->childCount();
+	if(!directories.isEmpty())
+	{
+		const int visible = beginAppendGroups(1);
+		appendGroup(hash, GROUP_DIRECTORY, fileCount);
+		for(QStringList::ConstIterator iterDir = directories.constBegin(); iterDir != directories.constEnd(); iterDir++)
+		{
+			appendFile((*iterDir), size);
+		}
+		endAppendGroups(visible);
+	}
+}
 
-	settings.clear();
+QModelIndex DuplicatesModel::addChange(const ResultStore::change_t &change)
+{
+	if(change.group.files.isEmpty() && change.removed.isEmpty())
+	{
+		return QModelIndex();
+	}
 
-	if((!settings.isWritable()) || (settings.status() != QSettings::NoError))
+	const int visible = beginAppendGroups(1);
+	const quint32 group = appendGroup(change.group.hash, GROUP_DUPLICATE, 0, change.changeType);
+	const QSet<QString> addedFiles = change.added.toSet();
+	for(QStringList::ConstIterator iterFile = change.group.files.constBegin(); (iterFile != change.group.files.constEnd()) && (change.changeType != ResultStore::CHANGE_RESOLVED); iterFile++)
 	{
-		qWarning("Failed to open output file!");
-		return false;
+		const bool added = (change.changeType != ResultStore::CHANGE_NEW) && addedFiles.contains(*iterFile);
+		appendFile((*iterFile), change.group.size, 0, added ? ResultStore::CHANGE_NEW : ResultStore::CHANGE_NONE);
+	}
+	for(QStringList::ConstIterator iterFile = change.removed.constBegin(); iterFile != change.removed.constEnd(); iterFile++)
+	{
+		appendFile((*iterFile), change.group.size, 0, ResultStore::CHANGE_RESOLVED);
 	}
+	endAppendGroups(visible);
 
-	settings.setValue("generator", tr("Document created with Double File Scanner v%1").arg(QString().sprintf("%u.%02u-%u", DOUBLESCANNER_VERSION_MAJOR, DOUBLESCANNER_VERSION_MINOR, DOUBLESCANNER_VERSION_PATCH)));
-	settings.setValue("rights", tr("Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>. Some rights reserved."));
+	return (visible > 0) ? createIndex(m_groupRow.at(group), 0, quint32(0)) : QModelIndex();
+}
 
-	for(int i = 0; i < groupCount; i++)
+/*replaces the group with the same digest, if the model already contains one, a visible group keeps its row*/
+QModelIndex DuplicatesModel::updateChange(const ResultStore::change_t &change)
+{
+	int oldRow = -1;
+	for(int group = m_groupType.count() - 1; group >= 0; group--)
 	{
-		if(DuplicateItem_Group *currentGroup = dynamic_cast<DuplicateItem_Group*>(m_root->child(i)))
+		if((m_groupType.at(group) == GROUP_DUPLICATE) && (groupDigest(group) == change.group.hash))
 		{
-			settings.beginGroup(currentGroup->getHash().toHex());
-			unsigned int counter = 0;
-			const int fileCount = currentGroup->childCount();
-			for(int j = 0; j < fileCount; j++)
+			const int row = m_groupRow.at(group);
+			if((row >= 0) && (row < m_fetchedGroups) && ((oldRow < 0) || (row < oldRow)))
 			{
-				if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentGroup->child(j)))
-				{
-					settings.setValue(QString().sprintf("%08u", counter++), QDir::toNativeSeparators(currentFile->getFilePath()));
-				}
+				oldRow = row;
 			}
-			settings.endGroup();
+			removeGroup(group);
 		}
 	}
 
-	if((!settings.isWritable()) || (settings.status() != QSettings::NoError))
+	compactFiles();
+
+	const int groupCount = m_groupType.count();
+	const QModelIndex index = addChange(change);
+	if((oldRow < 0) || (m_groupType.count() == groupCount))
 	{
-		qWarning("Failed to write output file!");
-		return false;
+		return index;
 	}
 
-	return true;
-}
-
-bool DuplicatesModel::exportToXml(const QString &outFile)
-{
-	QFile file(outFile);
-
-	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	/*the group was appended at the end, which may be beyond the rows fetched by the view*/
+	const quint32 group = quint32(groupCount);
+	const int row = m_groupRow.at(group);
+	if((row < 0) || (row <= oldRow))
 	{
-		qWarning("Failed to open output file!");
-		return false;
+		return index;
 	}
 
-	QXmlStreamWriter stream(&file);
-	const int groupCount = m_root->childCount();
+	const bool visible = (row < m_fetchedGroups);
+	if(visible)
+	{
+		beginMoveRows(QModelIndex(), row, row, QModelIndex(), oldRow);
+	}
+	else
+	{
+		beginInsertRows(QModelIndex(), oldRow, oldRow);
+	}
 
-	stream.setAutoFormatting(true);
-	stream.writeStartDocument();
+	m_groupOrder.remove(row);
+	m_groupOrder.insert(oldRow, group);
+	for(int i = oldRow; i <= row; i++)
+	{
+		m_groupRow[m_groupOrder.at(i)] = i;
+	}
+	m_generation++;
 
-	QString tmpl(" %1 ");
-	stream.writeComment(tmpl.arg(tr("=====================================================================")));
-	stream.writeComment(tmpl.arg(tr("Document created with Double File Scanner v%1").arg(QString().sprintf("%u.%02u-%u", DOUBLESCANNER_VERSION_MAJOR, DOUBLESCANNER_VERSION_MINOR, DOUBLESCANNER_VERSION_PATCH))));
-	stream.writeComment(tmpl.arg(tr("Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>. Some rights reserved.")));
-	stream.writeComment(tmpl.arg(tr("=====================================================================")));
+	if(visible)
+	{
+		endMoveRows();
+	}
+	else
+	{
+		m_fetchedGroups++;
+		endInsertRows();
+	}
 
-	stream.writeStartElement("Duplicates");
+	return createIndex(oldRow, 0, quint32(0));
+}
 
-	for(int i = 0; i < groupCount; i++)
+bool DuplicatesModel::renameFile(const QModelIndex &index, const QString &newFileName)
+{
+	const int slot = slotOf(index);
+	if(slot >= 0)
 	{
-		if(DuplicateItem_Group *currentGroup = dynamic_cast<DuplicateItem_Group*>(m_root->child(i)))
+		const QString oldFilePath = m_filePath.at(slot);
+		if(QFileInfo(oldFilePath).exists() && QFileInfo(oldFilePath).isFile())
 		{
-			stream.writeStartElement("Group");
-			stream.writeAttribute("Hash", currentGroup->getHash().toHex());
-			const int fileCount = currentGroup->childCount();
-			for(int j = 0; j < fileCount; j++)
+			QString newFilePath = QString("%1/%2").arg(QFileInfo(oldFilePath).absolutePath(), newFileName);
+			if(oldFilePath.compare(newFilePath, Qt::CaseInsensitive) == 0)
+			{
+				return true; /*no need to rename*/
+			}
+			if(QFileInfo(newFilePath).exists())
 			{
-				if(DuplicateItem_File *currentFile = dynamic_cast<DuplicateItem_File*>(currentGroup->child(j)))
+				const QString suffix   = QFileInfo(newFilePath).suffix();
+				const QString baseName = QFileInfo(newFilePath).completeBaseName();
+				const QString path     = QFileInfo(newFilePath).absolutePath();
+				for(int n = 2; QFileInfo(newFilePath).exists(); n++)
 				{
-					stream.writeStartElement("File");
-					stream.writeAttribute("Name", QDir::toNativeSeparators(currentFile->getFilePath()));
-					stream.writeEndElement();
+					newFilePath = QString("%1/%2 (%3).%4").arg(path, baseName, QString::number(n), suffix);
+					if(n > SHRT_MAX) return false;
 				}
 			}
-			stream.writeEndElement();
+			if(QFile::rename(oldFilePath, newFilePath))
+			{
+				m_filePath[slot] = newFilePath;
+				m_fileMatch.setBit(slot, (!m_filterText.isEmpty()) && newFilePath.contains(m_filterText, Qt::CaseInsensitive));
+				if(m_pathIndexed)
+				{
+					indexPath(quint32(index.internalId() - 1), newFilePath);
+				}
+				m_pathRank.clear();
+				m_generation++;
+				emit dataChanged(index, index);
+				return true;
+			}
 		}
 	}
 
+	return false;
+}
+
+bool DuplicatesModel::deleteFile(const QModelIndex &index)
+{
+	const int slot = slotOf(index);
+	if(slot >= 0)
+	{
+		const QString oldFilePath = m_filePath.at(slot);
+		QString archivePath, memberName;
+		if(QFileInfo(oldFilePath).isDir() || ArchiveReader::splitPath(oldFilePath, archivePath, memberName))
+		{
+			return false; /*never delete a whole directory or modify an archive*/
+		}
+		if(m_fileChange.at(slot) == ResultStore::CHANGE_RESOLVED)
+		{
+			return false; /*file is no longer a duplicate since the previous run*/
+		}
+		bool okay = true;
+		if(QFileInfo(oldFilePath).exists() && QFileInfo(oldFilePath).isFile())
+		{
+			okay = QFile::remove(oldFilePath);
+			if(!okay)
+			{
+				QFile::setPermissions(oldFilePath, QFile::ReadUser | QFile::WriteUser);
+				okay = QFile::remove(oldFilePath);
+			}
+		}
+		if(okay)
+		{
+			const int group = int(index.internalId() - 1);
+			beginRemoveRows(parent(index), index.row(), index.row());
+			const int last = int(m_groupFirst.at(group) + m_groupSize.at(group)) - 1;
+			for(int i = slot; i < last; i++)
+			{
+				m_filePath[i] = m_filePath.at(i + 1);
+				m_fileSize[i] = m_fileSize.at(i + 1);
+				m_fileModified[i] = m_fileModified.at(i + 1);
+				m_fileChange[i] = m_fileChange.at(i + 1);
+				m_fileMatch.setBit(i, m_fileMatch.testBit(i + 1));
+			}
+			m_groupSize[group]--;
+			m_deadFiles++;
+			m_pathRank.clear();
+			m_generation++;
+			endRemoveRows();
+			compactFiles();
+		}
+		return okay;
+	}
+
+	return false;
+}
+
+//===================================================================
+// Sort & Filter Functions
+//===================================================================
+
+/*the columns sort by member count, path and reclaimable space, a negative column restores the original order*/
+void DuplicatesModel::sort(int column, Qt::SortOrder order)
+{
+	switch(column)
+	{
+	case 0:
+		sortGroups(SORT_COUNT, order);
+		break;
+	case 1:
+		sortGroups(SORT_PATH, order);
+		break;
+	case 2:
+		sortGroups(SORT_RECLAIMABLE, order);
+		break;
+	default:
+		sortGroups(SORT_DEFAULT, Qt::AscendingOrder);
+		break;
+	}
+}
+
+void DuplicatesModel::sortGroups(const int &sortKey, const Qt::SortOrder &order)
+{
+	if((sortKey == m_sortKey) && (order == m_sortOrder) && (!m_orderDirty))
+	{
+		return;
+	}
+
+	m_sortKey = sortKey;
+	m_sortOrder = order;
+	updateGroupOrder();
+}
+
+/*only groups that have a file whose path contains the text and whose size is within the limits are shown*/
+void DuplicatesModel::setGroupFilter(const QString &pathText, const qint64 &minSize, const qint64 &maxSize)
+{
+	const QString filterText = QDir::fromNativeSeparators(pathText.trimmed());
+	if((filterText == m_filterText) && (minSize == m_filterMinSize) && (maxSize == m_filterMaxSize) && (!m_orderDirty))
+	{
+		return;
+	}
+
+	m_filterText = filterText;
+	m_filterMinSize = minSize;
+	m_filterMaxSize = maxSize;
+	updateGroupOrder();
+}
+
+bool DuplicatesModel::hasGroupFilter(void) const
+{
+	return (!m_filterText.isEmpty()) || (m_filterMinSize >= 0) || (m_filterMaxSize >= 0);
+}
+
+void DuplicatesModel::updateGroupOrder(void)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	if((m_sortKey == SORT_PATH) && (m_pathRank.count() != m_groupFirst.count()))
+	{
+		updatePathRank();
+	}
+
+	/*the trigram index is only built once the paths are searched for the first time*/
+	if((!m_filterText.isEmpty()) && (!m_pathIndexed))
+	{
+		buildPathIndex();
+	}
+
+	/*a file may only match if its group is a candidate, the others are cleared here*/
+	m_fileMatch.fill(false, m_filePath.count());
+
+	QVector<quint32> candidates;
+	const bool indexed = lookupPath(m_filterText, candidates);
+	const int count = indexed ? candidates.count() : m_groupFirst.count();
+
+	QVector<sortEntry_t> entries;
+	entries.reserve(count);
+
+	for(int i = 0; i < count; i++)
+	{
+		const quint32 group = indexed ? candidates.at(i) : quint32(i);
+		if((m_groupType.at(group) != REMOVED_GROUP) && matchesFilter(group))
+		{
+			const qint64 key = sortKey(group);
+			const sortEntry_t entry = { (m_sortOrder == Qt::DescendingOrder) ? (-key) : key, group };
+			entries << entry;
+		}
+	}
+
+	PARALLEL_SORT(entries, SORT_ENTRY_LESS_THAN);
+
+	beginResetModel();
+
+	m_groupOrder.resize(entries.count());
+	m_groupRow.fill(-1);
+	for(int row = 0; row < entries.count(); row++)
+	{
+		m_groupOrder[row] = entries.at(row).group;
+		m_groupRow[entries.at(row).group] = row;
+	}
+
+	m_fetchedGroups = qMin(m_groupOrder.count(), FETCH_PAGE_SIZE);
+	m_orderDirty = false;
+	m_generation++;
+
+	endResetModel();
+
+	qDebug("Ordered %d of %d groups in %lld ms.", entries.count(), m_groupFirst.count(), timer.elapsed());
+}
+
+/*the path order is computed once with string comparisons, later sorts only compare the rank*/
+void DuplicatesModel::updatePathRank(void)
+{
+	QVector<pathEntry_t> entries(m_groupFirst.count());
+	for(int group = 0; group < entries.count(); group++)
+	{
+		entries[group].path = (m_groupSize.at(group) > 0) ? m_filePath.at(m_groupFirst.at(group)) : QString();
+		entries[group].group = quint32(group);
+	}
+
+	PARALLEL_SORT(entries, PATH_ENTRY_LESS_THAN);
+
+	m_pathRank.resize(entries.count());
+	for(int rank = 0; rank < entries.count(); rank++)
+	{
+		m_pathRank[entries.at(rank).group] = quint32(rank);
+	}
+}
+
+qint64 DuplicatesModel::sortKey(const quint32 &group) const
+{
+	const qint64 fileCount = m_groupSize.at(group);
+	switch(m_sortKey)
+	{
+	case SORT_RECLAIMABLE:
+		if(m_groupType.at(group) == GROUP_OVERLAP)
+		{
+			return m_groupScore.at(group);
+		}
+		if((m_groupType.at(group) == GROUP_SIMILAR) || (fileCount < 2))
+		{
+			return 0;
+		}
+		return m_fileSize.at(m_groupFirst.at(group)) * (fileCount - 1);
+	case SORT_COUNT:
+		return fileCount;
+	case SORT_PATH:
+		return m_pathRank.at(group);
+	}
+	return group;
+}
+
+/*also marks the files whose path contains the filter text, so they don't need to be searched while painting*/
+bool DuplicatesModel::matchesFilter(const quint32 &group)
+{
+	if(!hasGroupFilter())
+	{
+		return true;
+	}
+
+	bool matches = false;
+	const int first = int(m_groupFirst.at(group)), last = first + int(m_groupSize.at(group));
+	for(int slot = first; slot < last; slot++)
+	{
+		const bool textMatch = (!m_filterText.isEmpty()) && m_filePath.at(slot).contains(m_filterText, Qt::CaseInsensitive);
+		if(textMatch)
+		{
+			m_fileMatch.setBit(slot);
+		}
+		if(((m_filterMinSize < 0) || (m_fileSize.at(slot) >= m_filterMinSize)) && ((m_filterMaxSize < 0) || (m_fileSize.at(slot) <= m_filterMaxSize)))
+		{
+			matches = matches || m_filterText.isEmpty() || textMatch;
+		}
+	}
+
+	return matches;
+}
+
+void DuplicatesModel::buildPathIndex(void)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	m_pathIndex.clear();
+	for(int group = 0; group < m_groupFirst.count(); group++)
+	{
+		const int first = int(m_groupFirst.at(group)), last = first + int(m_groupSize.at(group));
+		for(int slot = first; slot < last; slot++)
+		{
+			indexPath(quint32(group), m_filePath.at(slot));
+		}
+	}
+	m_pathIndexed = true;
+
+	qDebug("Indexed the paths of %d groups in %lld ms.", m_groupFirst.count(), timer.elapsed());
+}
+
+/*groups are added in ascending order, so a renamed file is the only case where an id has to be inserted*/
+void DuplicatesModel::indexPath(const quint32 &group, const QString &filePath)
+{
+	const QString foldedPath = filePath.toCaseFolded();
+	const QChar *const str = foldedPath.constData();
+	for(int i = 0; i + 2 < foldedPath.length(); i++)
+	{
+		QVector<quint32> &groups = m_pathIndex[TRIGRAM_KEY(str + i)];
+		if(groups.isEmpty() || (groups.last() < group))
+		{
+			groups << group;
+		}
+		else if(groups.last() != group)
+		{
+			QVector<quint32>::Iterator pos = qLowerBound(groups.begin(), groups.end(), group);
+			if((*pos) != group)
+			{
+				groups.insert(pos, group);
+			}
+		}
+	}
+}
+
+/*returns the groups that contain all trigrams of the text, those still need to be checked for the actual substring*/
+bool DuplicatesModel::lookupPath(const QString &text, QVector<quint32> &groups) const
+{
+	groups.clear();
+
+	const QString foldedText = text.toCaseFolded();
+	if(foldedText.length() < 3)
+	{
+		return false; /*too short, all groups have to be checked*/
+	}
+
+	QVector<const QVector<quint32>*> postings;
+	const QChar *const str = foldedText.constData();
+	for(int i = 0; i + 2 < foldedText.length(); i++)
+	{
+		QHash<quint64, QVector<quint32> >::ConstIterator iter = m_pathIndex.constFind(TRIGRAM_KEY(str + i));
+		if(iter == m_pathIndex.constEnd())
+		{
+			return true; /*no path contains this trigram*/
+		}
+		postings << &iter.value();
+	}
+
+	qSort(postings.begin(), postings.end(), POSTING_LESS_THAN);
+
+	groups = *postings.first();
+	for(int i = 1; (i < postings.count()) && (!groups.isEmpty()); i++)
+	{
+		QVector<quint32> common;
+		std::set_intersection(groups.constBegin(), groups.constEnd(), postings.at(i)->constBegin(), postings.at(i)->constEnd(), std::back_inserter(common));
+		groups.swap(common);
+	}
+
+	return true;
+}
+
+//===================================================================
+// Storage Functions
+//===================================================================
+
+int DuplicatesModel::groupOf(const QModelIndex &index) const
+{
+	if(index.isValid() && (index.internalId() == 0) && (index.row() < m_fetchedGroups))
+	{
+		return int(m_groupOrder.at(index.row()));
+	}
+	return -1;
+}
+
+int DuplicatesModel::slotOf(const QModelIndex &index) const
+{
+	if(index.isValid() && (index.internalId() > 0) && (index.internalId() <= m_groupFirst.count()))
+	{
+		const int group = int(index.internalId() - 1);
+		if((m_groupRow.at(group) >= 0) && (index.row() < int(m_groupSize.at(group))))
+		{
+			return int(m_groupFirst.at(group)) + index.row();
+		}
+	}
+	return -1;
+}
+
+QByteArray DuplicatesModel::groupDigest(const quint32 &group) const
+{
+	if((m_groupType.at(group) == GROUP_OVERLAP) || (m_groupType.at(group) == GROUP_SIMILAR))
+	{
+		return QByteArray();
+	}
+	return QByteArray(m_groupDigest.constData() + (group * DIGEST_SIZE), DIGEST_SIZE);
+}
+
+int DuplicatesModel::overlapPercent(const quint32 &group) const
+{
+	qint64 smallest = -1;
+	const int first = int(m_groupFirst.at(group)), last = first + int(m_groupSize.at(group));
+	for(int slot = first; slot < last; slot++)
+	{
+		smallest = (smallest < 0) ? m_fileSize.at(slot) : qMin(smallest, m_fileSize.at(slot));
+	}
+	return (smallest > 0) ? int(qMin(qint64(100), (m_groupScore.at(group) * 100) / smallest)) : 0;
+}
+
+/*the text of a cell is formatted on first use and kept in a small direct-mapped cache*/
+const QString &DuplicatesModel::displayText(const int &group, const int &slot, const int &column) const
+{
+	const quint64 key = (slot >= 0) ? ((quint64(slot) * 3U + quint64(column)) << 1) : ((quint64(group) << 1) | 1U);
+	const int entry = int(key & quint64(DISPLAY_CACHE_SIZE - 1));
+
+	if((m_cacheGeneration.at(entry) != m_generation) || (m_cacheKey.at(entry) != key))
+	{
+		m_cacheText[entry] = (slot >= 0) ? formatFile(slot, column) : formatGroup(group);
+		m_cacheKey[entry] = key;
+		m_cacheGeneration[entry] = m_generation;
+	}
+
+	return m_cacheText.at(entry);
+}
+
+QString DuplicatesModel::formatGroup(const int &group) const
+{
+	const int fileCount = int(m_groupSize.at(group));
+	if(m_groupType.at(group) == GROUP_OVERLAP)
+	{
+		return tr("Overlap: %1 shared (%2%)").arg(Utilities::sizeToString(m_groupScore.at(group)), QString::number(overlapPercent(group)));
+	}
+	if(m_groupType.at(group) == GROUP_SIMILAR)
+	{
+		return tr("Similar: %1% (%2%3)").arg(QString::number(m_groupScore.at(group)), QChar(ushort(0xd7)), QString::number(fileCount));
+	}
+	if(m_groupType.at(group) == GROUP_DIRECTORY)
+	{
+		return tr("Directory: %1 file(s) (%2%3)").arg(QString::number(m_groupScore.at(group)), QChar(ushort(0xd7)), QString::number(fileCount));
+	}
+	return CHANGE_LABEL(m_groupChange.at(group)) + QString().sprintf("%.16s (%c%d)", groupDigest(group).toHex().constData(), ushort(0xd7), fileCount);
+}
+
+QString DuplicatesModel::formatFile(const int &slot, const int &column) const
+{
+	const QString &filePath = m_filePath.at(slot);
+	switch(column)
+	{
+		case 0:
+			if(m_fileChange.at(slot) == ResultStore::CHANGE_NEW)      return QString("+ %1").arg(LIMIT_STR(FILE_NAME(filePath), 30));
+			if(m_fileChange.at(slot) == ResultStore::CHANGE_RESOLVED) return QString("- %1").arg(LIMIT_STR(FILE_NAME(filePath), 30));
+			return LIMIT_STR(FILE_NAME(filePath), 32);
+		case 1: return QDir::toNativeSeparators(PARENT_PATH(filePath));
+		case 2: return Utilities::sizeToString(m_fileSize.at(slot));
+	}
+	return QString();
+}
+
+/*must be called between beginAppendGroups() and endAppendGroups(), the new group becomes the last row*/
+quint32 DuplicatesModel::appendGroup(const QByteArray &hash, const int &groupType, const qint64 &score, const int &changeType)
+{
+	const quint32 group = quint32(m_groupFirst.count());
+
+	m_groupFirst << quint32(m_filePath.count());
+	m_groupSize << 0U;
+	m_groupScore << score;
+	m_groupType << quint8(groupType);
+	m_groupChange << quint8(changeType);
+	m_groupDigest.append(hash.left(DIGEST_SIZE).leftJustified(DIGEST_SIZE, '\0', true));
+
+	m_groupRow << m_groupOrder.count();
+	m_groupOrder << group;
+
+	/*new groups are appended to the current order and bypass the filter until the groups are sorted again*/
+	m_pathRank.clear();
+	m_orderDirty = m_orderDirty || (m_sortKey != SORT_DEFAULT) || hasGroupFilter();
+
+	return group;
+}
+
+/*new groups show up right away as long as the view has all groups and the first page isn't full yet*/
+int DuplicatesModel::beginAppendGroups(const int &count)
+{
+	if((count > 0) && (m_fetchedGroups == m_groupOrder.count()) && (m_fetchedGroups < FETCH_PAGE_SIZE))
+	{
+		const int visible = qMin(count, FETCH_PAGE_SIZE - m_fetchedGroups);
+		beginInsertRows(QModelIndex(), m_fetchedGroups, m_fetchedGroups + visible - 1);
+		return visible;
+	}
+	return 0;
+}
+
+void DuplicatesModel::endAppendGroups(const int &visible)
+{
+	if(visible > 0)
+	{
+		m_fetchedGroups += visible;
+		endInsertRows();
+	}
+}
+
+/*files are always added to the group that was appended last*/
+void DuplicatesModel::appendFile(const QString &filePath, const qint64 &fileSize, const qint64 &modified, const int &changeType)
+{
+	m_filePath << filePath;
+	m_fileSize << fileSize;
+	m_fileModified << modified;
+	m_fileChange << quint8(changeType);
+	m_fileMatch.resize(m_filePath.count());
+	m_fileMatch.setBit(m_filePath.count() - 1, (!m_filterText.isEmpty()) && filePath.contains(m_filterText, Qt::CaseInsensitive));
+	m_groupSize.last()++;
+	if(m_pathIndexed)
+	{
+		indexPath(quint32(m_groupFirst.count() - 1), filePath);
+	}
+}
+
+void DuplicatesModel::removeGroup(const quint32 &group)
+{
+	const int row = m_groupRow.at(group);
+	const bool visible = (row >= 0) && (row < m_fetchedGroups);
+	if(visible)
+	{
+		beginRemoveRows(QModelIndex(), row, row);
+	}
+
+	m_deadFiles += m_groupSize.at(group);
+	m_groupSize[group] = 0;
+	m_groupType[group] = REMOVED_GROUP;
+	m_groupRow[group] = -1;
+
+	if(row >= 0)
+	{
+		m_groupOrder.remove(row);
+		for(int i = row; i < m_groupOrder.count(); i++)
+		{
+			m_groupRow[m_groupOrder.at(i)] = i;
+		}
+	}
+	m_generation++;
+
+	if(visible)
+	{
+		m_fetchedGroups--;
+		endRemoveRows();
+	}
+}
+
+/*slots of removed files are reclaimed once they make up half of the storage, the group ids are not affected*/
+void DuplicatesModel::compactFiles(void)
+{
+	if(m_deadFiles <= quint32(m_filePath.count() / 2))
+	{
+		return;
+	}
+
+	int target = 0;
+	for(int group = 0; group < m_groupFirst.count(); group++)
+	{
+		const int first = int(m_groupFirst.at(group)), count = int(m_groupSize.at(group));
+		m_groupFirst[group] = quint32(target);
+		for(int i = first; i < first + count; i++, target++)
+		{
+			if(i != target)
+			{
+				m_filePath[target] = m_filePath.at(i);
+				m_fileSize[target] = m_fileSize.at(i);
+				m_fileModified[target] = m_fileModified.at(i);
+				m_fileChange[target] = m_fileChange.at(i);
+				m_fileMatch.setBit(target, m_fileMatch.testBit(i));
+			}
+		}
+	}
+
+	m_filePath.resize(target);
+	m_fileMatch.resize(target);
+	m_fileSize.resize(target);
+	m_fileModified.resize(target);
+	m_fileChange.resize(target);
+	m_deadFiles = 0;
+	m_generation++;
+}
+
+//===================================================================
+// Export Functions
+//===================================================================
+
+bool DuplicatesModel::exportToFile(const QString &outFile, const int &format)
+{
+	switch(format)
+	{
+	case FORMAT_INI:
+		return exportToIni(outFile);
+		break;
+	case FORMAT_XML:
+		return exportToXml(outFile);
+		break;
+	}
+
+	return false;
+}
+
+bool DuplicatesModel::exportToIni(const QString &outFile)
+{
+	QSettings settings(outFile, QSettings::IniFormat);
+
+	settings.clear();
+
+	if((!settings.isWritable()) || (settings.status() != QSettings::NoError))
+	{
+		qWarning("Failed to open output file!");
+		return false;
+	}
+
+	settings.setValue("generator", tr("Document created with Double File Scanner v%1").arg(QString().sprintf("%u.%02u-%u", DOUBLESCANNER_VERSION_MAJOR, DOUBLESCANNER_VERSION_MINOR, DOUBLESCANNER_VERSION_PATCH)));
+	settings.setValue("rights", tr("Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>. Some rights reserved."));
+
+	unsigned int overlapCounter = 0, similarCounter = 0, directoryCounter = 0;
+
+	for(QVector<quint32>::ConstIterator iter = m_groupOrder.constBegin(); iter != m_groupOrder.constEnd(); iter++)
+	{
+		if(m_groupType.at(*iter) == GROUP_OVERLAP)
+		{
+			settings.beginGroup(QString().sprintf("overlap_%08u", overlapCounter++));
+			settings.setValue("shared", m_groupScore.at(*iter));
+		}
+		else if(m_groupType.at(*iter) == GROUP_SIMILAR)
+		{
+			settings.beginGroup(QString().sprintf("similar_%08u", similarCounter++));
+			settings.setValue("similarity", m_groupScore.at(*iter));
+		}
+		else if(m_groupType.at(*iter) == GROUP_DIRECTORY)
+		{
+			settings.beginGroup(QString().sprintf("directory_%08u", directoryCounter++));
+			settings.setValue("hash", QString::fromLatin1(groupDigest(*iter).toHex().constData()));
+			settings.setValue("files", m_groupScore.at(*iter));
+		}
+		else
+		{
+			settings.beginGroup(groupDigest(*iter).toHex());
+			if(m_groupChange.at(*iter) != ResultStore::CHANGE_NONE)
+			{
+				settings.setValue("change", ResultStore::changeName(m_groupChange.at(*iter)));
+			}
+		}
+		unsigned int counter = 0;
+		const int first = int(m_groupFirst.at(*iter)), last = first + int(m_groupSize.at(*iter));
+		for(int slot = first; slot < last; slot++)
+		{
+			settings.setValue(QString().sprintf("%08u", counter++), QDir::toNativeSeparators(m_filePath.at(slot)));
+		}
+		settings.endGroup();
+	}
+
+	if((!settings.isWritable()) || (settings.status() != QSettings::NoError))
+	{
+		qWarning("Failed to write output file!");
+		return false;
+	}
+
+	return true;
+}
+
+bool DuplicatesModel::exportToXml(const QString &outFile)
+{
+	QFile file(outFile);
+
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Failed to open output file!");
+		return false;
+	}
+
+	QXmlStreamWriter stream(&file);
+
+	stream.setAutoFormatting(true);
+	stream.writeStartDocument();
+
+	QString tmpl(" %1 ");
+	stream.writeComment(tmpl.arg(tr("=====================================================================")));
+	stream.writeComment(tmpl.arg(tr("Document created with Double File Scanner v%1").arg(QString().sprintf("%u.%02u-%u", DOUBLESCANNER_VERSION_MAJOR, DOUBLESCANNER_VERSION_MINOR, DOUBLESCANNER_VERSION_PATCH))));
+	stream.writeComment(tmpl.arg(tr("Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>. Some rights reserved.")));
+	stream.writeComment(tmpl.arg(tr("=====================================================================")));
+
+	stream.writeStartElement("Duplicates");
+
+	for(QVector<quint32>::ConstIterator iter = m_groupOrder.constBegin(); iter != m_groupOrder.constEnd(); iter++)
+	{
+		if(m_groupType.at(*iter) == GROUP_OVERLAP)
+		{
+			stream.writeStartElement("Overlap");
+			stream.writeAttribute("Shared", QString::number(m_groupScore.at(*iter)));
+		}
+		else if(m_groupType.at(*iter) == GROUP_SIMILAR)
+		{
+			stream.writeStartElement("Similar");
+			stream.writeAttribute("Score", QString::number(m_groupScore.at(*iter)));
+		}
+		else if(m_groupType.at(*iter) == GROUP_DIRECTORY)
+		{
+			stream.writeStartElement("Directory");
+			stream.writeAttribute("Hash", groupDigest(*iter).toHex());
+			stream.writeAttribute("Files", QString::number(m_groupScore.at(*iter)));
+		}
+		else
+		{
+			stream.writeStartElement("Group");
+			stream.writeAttribute("Hash", groupDigest(*iter).toHex());
+			if(m_groupChange.at(*iter) != ResultStore::CHANGE_NONE)
+			{
+				stream.writeAttribute("Change", ResultStore::changeName(m_groupChange.at(*iter)));
+			}
+		}
+		const int first = int(m_groupFirst.at(*iter)), last = first + int(m_groupSize.at(*iter));
+		for(int slot = first; slot < last; slot++)
+		{
+			stream.writeStartElement("File");
+			stream.writeAttribute("Name", QDir::toNativeSeparators(m_filePath.at(slot)));
+			stream.writeAttribute("Size", QString::number(m_fileSize.at(slot)));
+			if(m_fileModified.at(slot) > 0)
+			{
+				stream.writeAttribute("Modified", QDateTime::fromMSecsSinceEpoch(m_fileModified.at(slot)).toUTC().toString(Qt::ISODate));
+			}
+			if(m_fileChange.at(slot) == ResultStore::CHANGE_NEW)
+			{
+				stream.writeAttribute("Change", "added");
+			}
+			else if(m_fileChange.at(slot) == ResultStore::CHANGE_RESOLVED)
+			{
+				stream.writeAttribute("Change", "removed");
+			}
+			stream.writeEndElement();
+		}
+		stream.writeEndElement();
+	}
+
 	stream.writeEndElement();
 	
 	if(stream.hasError())
@@ -664,3 +1497,99 @@ bool DuplicatesModel::exportToXml(const QString &outFile)
 	file.close();
 	return true;
 }
+
+//===================================================================
+// Benchmark Functions
+//===================================================================
+
+/*
+ * Fills a model with synthetic groups and measures the data() calls per second for each role.
+ * "Scroll" visits every cell once, "Repaint" keeps asking for the cells of one screen page.
+ */
+void DuplicatesModel::benchmark(const int &groupCount)
+{
+	static const int FILES_PER_GROUP = 3, PAGE_ROWS = 64, BATCH_SIZE = 256;
+	static const qint64 TIME_LIMIT = 2000;
+	static const int roles[] = { Qt::DisplayRole, Qt::ToolTipRole, Qt::DecorationRole, Qt::TextAlignmentRole, Qt::FontRole, -1 };
+	static const char *const names[] = { "Display", "ToolTip", "Decoration", "TextAlignment", "Font", NULL };
+
+	DuplicatesModel model;
+	QElapsedTimer timer;
+
+	timer.start();
+	QList<duplicateGroup_t> batch;
+	for(int i = 0; i < groupCount; i++)
+	{
+		duplicateGroup_t group;
+		group.hash = QByteArray::number(i).leftJustified(DIGEST_SIZE, '#');
+		for(int j = 0; j < FILES_PER_GROUP; j++)
+		{
+			group.files << MAKE_FILE_RECORD(QString().sprintf("C:/Benchmark/Folder_%05d/File_%08d_%d.dat", i % 10000, i, j), qint64(i) * 4096 + 1);
+		}
+		batch << group;
+		if((batch.count() >= BATCH_SIZE) || (i + 1 == groupCount))
+		{
+			model.addDuplicates(batch); /*the same path as the comparator takes*/
+			batch.clear();
+		}
+	}
+	qDebug("[Model Benchmark]\nCreated %d groups in %lld ms.", groupCount, timer.elapsed());
+
+	timer.restart();
+	while(model.canFetchMore(QModelIndex()))
+	{
+		model.fetchMore(QModelIndex());
+	}
+	qDebug("Fetched all groups in %lld ms.", timer.elapsed());
+
+	QList<QModelIndex> cells;
+	for(int i = 0; i < model.rowCount(); i++)
+	{
+		const QModelIndex group = model.index(i, 0);
+		cells << group;
+		for(int j = 0; j < model.rowCount(group); j++)
+		{
+			for(int k = 0; k < 3; k++)
+			{
+				cells << model.index(j, k, group);
+			}
+		}
+	}
+
+	const int pageCells = qMin(cells.count(), PAGE_ROWS * 3);
+	for(int r = 0; roles[r] >= 0; r++)
+	{
+		for(int pass = 0; pass < 2; pass++)
+		{
+			const int limit = (pass > 0) ? pageCells : cells.count();
+			qint64 calls = 0;
+			model.m_generation++;
+			timer.restart();
+			do
+			{
+				for(int i = 0; i < limit; i++)
+				{
+					model.data(cells.at(i), roles[r]);
+				}
+				calls += limit;
+			}
+			while((limit > 0) && (pass > 0) && (timer.elapsed() < TIME_LIMIT));
+			const qint64 elapsed = qMax(timer.nsecsElapsed(), qint64(1));
+			qDebug("%-13s %-7s %12.0f calls/s", names[r], (pass > 0) ? "Repaint" : "Scroll", double(calls) * 1000000000.0 / double(elapsed));
+		}
+	}
+
+	static const char *const queries[] = { "folder_00042/", "file_%08d_1", "_2.dat", "no_such_file", NULL };
+	for(int q = 0; queries[q]; q++)
+	{
+		const QString query = QString().sprintf(queries[q], groupCount / 2);
+		timer.restart();
+		model.setGroupFilter(query);
+		qDebug("Search %-16s %8d groups in %lld ms.", query.toLatin1().constData(), model.m_groupOrder.count(), timer.elapsed());
+	}
+	model.setGroupFilter(QString());
+
+	timer.restart();
+	model.clear();
+	qDebug("Cleared the model in %lld ms.\n", timer.elapsed());
+}
@@ -24,8 +24,13 @@
 
 #include <QAbstractItemModel>
 #include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QBitArray>
+
+#include "ResultStore.h"
+#include "FileRecord.h"
 
-class DuplicateItem;
 class QFile;
 
 //DuplicatesModel class
@@ -44,6 +49,8 @@ public:
 	virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
 	virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
 	virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+	virtual bool canFetchMore(const QModelIndex &parent) const;
+	virtual void fetchMore(const QModelIndex &parent);
 	
 	//Export formats
 	typedef enum
@@ -53,30 +60,125 @@ public:
 	}
 	exportFormat_t;
 
+	//Group types
+	typedef enum
+	{
+		GROUP_DUPLICATE = 0,
+		GROUP_OVERLAP   = 1,
+		GROUP_SIMILAR   = 2,
+		GROUP_DIRECTORY = 3
+	}
+	groupType_t;
+
+	//Sort keys
+	typedef enum
+	{
+		SORT_DEFAULT     = 0,
+		SORT_RECLAIMABLE = 1,
+		SORT_COUNT       = 2,
+		SORT_PATH        = 3
+	}
+	sortKey_t;
+
+	virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+	void sortGroups(const int &sortKey, const Qt::SortOrder &order = Qt::DescendingOrder);
+	void setGroupFilter(const QString &pathText, const qint64 &minSize = -1, const qint64 &maxSize = -1);
+	bool hasGroupFilter(void) const;
+
 	unsigned int duplicateCount(void) const;
+	unsigned int groupCount(const int &groupType) const;
+	unsigned int changeCount(const int &changeType) const;
+	QList<ResultStore::group_t> duplicateGroups(void) const;
+	int getGroupType(const QModelIndex &index) const;
 	unsigned int duplicateFileCount(const QModelIndex &index) const;
 	const QString getFilePath(const QModelIndex &index) const;
 	const qint64 &getFileSize(const QModelIndex &index) const;
-	const QByteArray &getGroupHash(const QModelIndex &index) const;
+	QByteArray getGroupHash(const QModelIndex &index) const;
 	QString toString(void);
 	
 	void clear(void);
 	bool renameFile(const QModelIndex &index, const QString &newFileName);
 	bool deleteFile(const QModelIndex &index);
+	QModelIndex addChange(const ResultStore::change_t &change);
+	QModelIndex updateChange(const ResultStore::change_t &change);
 
 	bool exportToFile(const QString &outFile, const int &format);
+	static void benchmark(const int &groupCount);
 
 public slots:
-	void addDuplicate(const QByteArray &hash, const QStringList &files, const qint64 &size);
+	void addDuplicates(const QList<duplicateGroup_t> &groups);
+	void addOverlap(const QStringList &files, const QList<qint64> &sizes, const qint64 &sharedBytes);
+	void addSimilar(const QStringList &files, const QList<qint64> &sizes, const int &similarity);
+	void addDirectory(const QByteArray &hash, const QStringList &directories, const qint64 &size, const int &fileCount);
 
 protected:
-	DuplicateItem *m_root;
+	//Groups, indexed by group id
+	QVector<quint32> m_groupFirst;
+	QVector<quint32> m_groupSize;
+	QVector<qint64> m_groupScore;
+	QVector<quint8> m_groupType;
+	QVector<quint8> m_groupChange;
+	QByteArray m_groupDigest;
+
+	//Row order of the groups
+	QVector<quint32> m_groupOrder;
+	QVector<qint32> m_groupRow;
+
+	//Files, indexed by slot
+	QVector<QString> m_filePath;
+	QVector<qint64> m_fileSize;
+	QVector<qint64> m_fileModified;
+	QVector<quint8> m_fileChange;
+	QBitArray m_fileMatch; /*the path contains the filter text*/
+	quint32 m_deadFiles;
+	int m_fetchedGroups;
+
+	//Order and filter of the rows
+	int m_sortKey;
+	Qt::SortOrder m_sortOrder;
+	QString m_filterText;
+	qint64 m_filterMinSize;
+	qint64 m_filterMaxSize;
+	bool m_orderDirty;
+	QVector<quint32> m_pathRank;
+
+	//Trigram index of the file paths, each trigram maps to the ascending ids of the groups containing it
+	QHash<quint64, QVector<quint32> > m_pathIndex;
+	bool m_pathIndexed;
+
+	//Cache of formatted cells
+	quint32 m_generation;
+	mutable QVector<quint64> m_cacheKey;
+	mutable QVector<quint32> m_cacheGeneration;
+	mutable QVector<QString> m_cacheText;
 
 	QIcon *m_iconDflt;
 	QIcon *m_iconDupl;
 	QFont *m_fontDflt;
 	QFont *m_fontBold;
 
+	int groupOf(const QModelIndex &index) const;
+	int slotOf(const QModelIndex &index) const;
+	QByteArray groupDigest(const quint32 &group) const;
+	int overlapPercent(const quint32 &group) const;
+	const QString &displayText(const int &group, const int &slot, const int &column) const;
+	QString formatGroup(const int &group) const;
+	QString formatFile(const int &slot, const int &column) const;
+
+	quint32 appendGroup(const QByteArray &hash, const int &groupType = GROUP_DUPLICATE, const qint64 &score = 0, const int &changeType = ResultStore::CHANGE_NONE);
+	void appendFile(const QString &filePath, const qint64 &fileSize, const qint64 &modified = 0, const int &changeType = ResultStore::CHANGE_NONE);
+	int beginAppendGroups(const int &count);
+	void endAppendGroups(const int &visible);
+	void removeGroup(const quint32 &group);
+	void compactFiles(void);
+	void updateGroupOrder(void);
+	void updatePathRank(void);
+	qint64 sortKey(const quint32 &group) const;
+	bool matchesFilter(const quint32 &group);
+	void buildPathIndex(void);
+	void indexPath(const quint32 &group, const QString &filePath);
+	bool lookupPath(const QString &text, QVector<quint32> &groups) const;
+
 	bool exportToIni(const QString &outFile);
 	bool exportToXml(const QString &outFile);
 };
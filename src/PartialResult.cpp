@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PartialResult.h"
+
+static const quint32 PARTIAL_MAGIC   = 0x44534350; /*"DSCP"*/
+static const quint32 PARTIAL_VERSION = 2;
+static const quint8  RECORD_FILE = 0x01;
+static const quint8  RECORD_EOF  = 0xFF;
+static const int     HASH_SIZE   = 20;
+
+//=======================================================================================
+// Partial Result Writer
+//=======================================================================================
+
+PartialResultWriter::PartialResultWriter(void)
+:
+	m_recordCount(0)
+{
+}
+
+PartialResultWriter::~PartialResultWriter(void)
+{
+	if(m_file.isOpen())
+	{
+		qWarning("Partial result was not closed properly!");
+		m_file.close();
+	}
+}
+
+bool PartialResultWriter::open(const QString &outFile)
+{
+	m_file.setFileName(outFile);
+	m_recordCount = 0;
+
+	if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Failed to open partial result file: %s", outFile.toUtf8().constData());
+		return false;
+	}
+
+	m_stream.setDevice(&m_file);
+	m_stream.setVersion(QDataStream::Qt_4_8);
+	m_stream << PARTIAL_MAGIC << PARTIAL_VERSION;
+
+	return (m_stream.status() == QDataStream::Ok);
+}
+
+bool PartialResultWriter::write(const QByteArray &hash, const fileRecord_t &record)
+{
+	if((hash.size() != HASH_SIZE) || record.path.isEmpty())
+	{
+		qWarning("Invalid record for partial result, skipping!");
+		return false;
+	}
+
+	m_stream << RECORD_FILE << record.size << record.mtime;
+	m_stream.writeRawData(hash.constData(), HASH_SIZE);
+	m_stream << record.path.toUtf8();
+	m_recordCount++;
+
+	return (m_stream.status() == QDataStream::Ok);
+}
+
+bool PartialResultWriter::close(void)
+{
+	if(!m_file.isOpen())
+	{
+		return false;
+	}
+
+	m_stream << RECORD_EOF << m_recordCount;
+	const bool okay = (m_stream.status() == QDataStream::Ok) && (m_file.error() == QFile::NoError);
+
+	m_stream.setDevice(NULL);
+	m_file.close();
+
+	return okay;
+}
+
+//=======================================================================================
+// Partial Result Reader
+//=======================================================================================
+
+PartialResultReader::PartialResultReader(void)
+:
+	m_recordCount(0),
+	m_complete(false)
+{
+}
+
+PartialResultReader::~PartialResultReader(void)
+{
+	close();
+}
+
+bool PartialResultReader::open(const QString &inFile)
+{
+	m_file.setFileName(inFile);
+	m_recordCount = 0;
+	m_complete = false;
+
+	if(!m_file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Failed to open partial result file: %s", inFile.toUtf8().constData());
+		return false;
+	}
+
+	m_stream.setDevice(&m_file);
+	m_stream.setVersion(QDataStream::Qt_4_8);
+
+	quint32 magic = 0, version = 0;
+	m_stream >> magic >> version;
+
+	if((m_stream.status() != QDataStream::Ok) || (magic != PARTIAL_MAGIC) || (version != PARTIAL_VERSION))
+	{
+		qWarning("Not a valid partial result file: %s", inFile.toUtf8().constData());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool PartialResultReader::read(QByteArray &hash, fileRecord_t &record)
+{
+	if((!m_file.isOpen()) || m_complete)
+	{
+		return false;
+	}
+
+	quint8 type = 0;
+	m_stream >> type;
+
+	if(type == RECORD_FILE)
+	{
+		QByteArray utf8Path;
+		hash.resize(HASH_SIZE);
+		m_stream >> record.size >> record.mtime;
+		m_stream.readRawData(hash.data(), HASH_SIZE);
+		m_stream >> utf8Path;
+		if(m_stream.status() == QDataStream::Ok)
+		{
+			record.path = QString::fromUtf8(utf8Path.constData(), utf8Path.size());
+			record.attributes = 0;
+			m_recordCount++;
+			return true;
+		}
+	}
+	else if(type == RECORD_EOF)
+	{
+		quint64 recordCount = 0;
+		m_stream >> recordCount;
+		m_complete = (m_stream.status() == QDataStream::Ok) && (recordCount == m_recordCount);
+		if(!m_complete)
+		{
+			qWarning("Partial result is inconsistent: %s", m_file.fileName().toUtf8().constData());
+		}
+		return false;
+	}
+
+	qWarning("Partial result is truncated: %s", m_file.fileName().toUtf8().constData());
+	return false;
+}
+
+bool PartialResultReader::isComplete(void) const
+{
+	return m_complete;
+}
+
+void PartialResultReader::close(void)
+{
+	if(m_file.isOpen())
+	{
+		m_stream.setDevice(NULL);
+		m_file.close();
+	}
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QDataStream>
+
+#include "FileRecord.h"
+
+//=======================================================================================
+
+/*
+ * Partial results are written by the worker processes of a sharded scan. Each record
+ * holds the size, the modification time, the SHA-1 digest and the path of a single
+ * file. The records of any number of partial results can be merged into the final
+ * duplicate groups later.
+ */
+
+class PartialResultWriter
+{
+public:
+	PartialResultWriter(void);
+	~PartialResultWriter(void);
+
+	bool open(const QString &outFile);
+	bool write(const QByteArray &hash, const fileRecord_t &record);
+	bool close(void);
+
+protected:
+	QFile m_file;
+	QDataStream m_stream;
+	quint64 m_recordCount;
+};
+
+//=======================================================================================
+
+class PartialResultReader
+{
+public:
+	PartialResultReader(void);
+	~PartialResultReader(void);
+
+	bool open(const QString &inFile);
+	bool read(QByteArray &hash, fileRecord_t &record);
+	bool isComplete(void) const;
+	void close(void);
+
+protected:
+	QFile m_file;
+	QDataStream m_stream;
+	quint64 m_recordCount;
+	bool m_complete;
+};
@@ -0,0 +1,355 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResultStore.h"
+
+static const quint32 STORE_MAGIC   = 0x44534352; /*"DSCR"*/
+static const quint32 STORE_VERSION = 1;
+static const quint8  RECORD_GROUP = 0x01;
+static const quint8  RECORD_EOF   = 0xFF;
+static const int     HASH_SIZE    = 20;
+
+static bool groupHashLessThan(const ResultStore::group_t &a, const ResultStore::group_t &b)
+{
+	return a.hash < b.hash;
+}
+
+/*both lists must be sorted, the result lists receive the entries that only one of them has*/
+static void MERGE_FILES(const QStringList &previous, const QStringList &current, QStringList &removed, QStringList &added)
+{
+	QStringList::ConstIterator iterPrev = previous.constBegin(), iterCurr = current.constBegin();
+	while((iterPrev != previous.constEnd()) || (iterCurr != current.constEnd()))
+	{
+		if((iterCurr == current.constEnd()) || ((iterPrev != previous.constEnd()) && ((*iterPrev) < (*iterCurr))))
+		{
+			removed << (*(iterPrev++));
+		}
+		else if((iterPrev == previous.constEnd()) || ((*iterCurr) < (*iterPrev)))
+		{
+			added << (*(iterCurr++));
+		}
+		else
+		{
+			iterPrev++;
+			iterCurr++;
+		}
+	}
+}
+
+//=======================================================================================
+// Result Store
+//=======================================================================================
+
+void ResultStore::sortGroups(QList<group_t> &groups)
+{
+	for(QList<group_t>::Iterator iter = groups.begin(); iter != groups.end(); iter++)
+	{
+		iter->files.sort();
+	}
+	qSort(groups.begin(), groups.end(), groupHashLessThan);
+}
+
+bool ResultStore::save(const QString &outFile, const QList<group_t> &groups)
+{
+	ResultStoreWriter writer;
+	if(!writer.open(outFile))
+	{
+		return false;
+	}
+
+	bool okay = true;
+	for(QList<group_t>::ConstIterator iter = groups.constBegin(); iter != groups.constEnd(); iter++)
+	{
+		okay = writer.write(*iter) && okay;
+	}
+
+	return writer.close() && okay;
+}
+
+/*the groups must have been sorted by sortGroups() before*/
+bool ResultStore::diff(const QString &previousFile, const QList<group_t> &groups, QList<change_t> &changes)
+{
+	ResultStoreReader reader;
+	if(!reader.open(previousFile))
+	{
+		return false;
+	}
+
+	group_t previous;
+	bool havePrevious = reader.read(previous);
+	QByteArray lastHash;
+
+	QList<group_t>::ConstIterator current = groups.constBegin();
+
+	while(havePrevious || (current != groups.constEnd()))
+	{
+		change_t change;
+		change.changeType = CHANGE_NONE;
+
+		if((current == groups.constEnd()) || (havePrevious && (previous.hash < current->hash)))
+		{
+			change.changeType = CHANGE_RESOLVED;
+			change.group = previous;
+			change.removed = previous.files;
+		}
+		else if((!havePrevious) || (current->hash < previous.hash))
+		{
+			change.changeType = CHANGE_NEW;
+			change.group = (*current);
+			change.added = current->files;
+		}
+		else
+		{
+			diffGroup(previous, (*current), change);
+		}
+
+		const bool advancePrevious = (change.changeType != CHANGE_NEW);
+		const bool advanceCurrent = (change.changeType != CHANGE_RESOLVED);
+
+		if(change.changeType != CHANGE_NONE)
+		{
+			changes << change;
+		}
+
+		if(advancePrevious)
+		{
+			lastHash = previous.hash;
+			havePrevious = reader.read(previous);
+			if(havePrevious && (!(lastHash < previous.hash)))
+			{
+				qWarning("Result store is not sorted: %s", previousFile.toUtf8().constData());
+				return false;
+			}
+		}
+		if(advanceCurrent)
+		{
+			current++;
+		}
+	}
+
+	return reader.isComplete();
+}
+
+/*compares two versions of the same group, the file lists of both must be sorted*/
+void ResultStore::diffGroup(const group_t &previous, const group_t &current, change_t &change)
+{
+	change.changeType = CHANGE_NONE;
+	change.group = current;
+	change.added.clear();
+	change.removed.clear();
+
+	MERGE_FILES(previous.files, current.files, change.removed, change.added);
+	if(!(change.added.isEmpty() && change.removed.isEmpty()))
+	{
+		change.changeType = change.removed.isEmpty() ? CHANGE_GROWN : CHANGE_CHANGED;
+	}
+}
+
+/*the name of a change type, as written to the exported results*/
+QString ResultStore::changeName(const int &changeType)
+{
+	switch(changeType)
+	{
+		case CHANGE_NEW:      return QString::fromLatin1("new");
+		case CHANGE_GROWN:    return QString::fromLatin1("grown");
+		case CHANGE_CHANGED:  return QString::fromLatin1("changed");
+		case CHANGE_RESOLVED: return QString::fromLatin1("resolved");
+	}
+	return QString::fromLatin1("unchanged");
+}
+
+//=======================================================================================
+// Result Store Writer
+//=======================================================================================
+
+ResultStoreWriter::ResultStoreWriter(void)
+:
+	m_recordCount(0)
+{
+}
+
+ResultStoreWriter::~ResultStoreWriter(void)
+{
+	if(m_file.isOpen())
+	{
+		qWarning("Result store was not closed properly!");
+		m_file.close();
+	}
+}
+
+bool ResultStoreWriter::open(const QString &outFile)
+{
+	m_file.setFileName(outFile);
+	m_recordCount = 0;
+
+	if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Failed to open result store: %s", outFile.toUtf8().constData());
+		return false;
+	}
+
+	m_stream.setDevice(&m_file);
+	m_stream.setVersion(QDataStream::Qt_4_8);
+	m_stream << STORE_MAGIC << STORE_VERSION;
+
+	return (m_stream.status() == QDataStream::Ok);
+}
+
+bool ResultStoreWriter::write(const ResultStore::group_t &group)
+{
+	if((group.hash.size() != HASH_SIZE) || group.files.isEmpty())
+	{
+		qWarning("Invalid record for result store, skipping!");
+		return false;
+	}
+
+	m_stream << RECORD_GROUP << group.size;
+	m_stream.writeRawData(group.hash.constData(), HASH_SIZE);
+	m_stream << quint32(group.files.count());
+	for(QStringList::ConstIterator iter = group.files.constBegin(); iter != group.files.constEnd(); iter++)
+	{
+		m_stream << iter->toUtf8();
+	}
+	m_recordCount++;
+
+	return (m_stream.status() == QDataStream::Ok);
+}
+
+bool ResultStoreWriter::close(void)
+{
+	if(!m_file.isOpen())
+	{
+		return false;
+	}
+
+	m_stream << RECORD_EOF << m_recordCount;
+	const bool okay = (m_stream.status() == QDataStream::Ok) && (m_file.error() == QFile::NoError);
+
+	m_stream.setDevice(NULL);
+	m_file.close();
+
+	return okay;
+}
+
+//=======================================================================================
+// Result Store Reader
+//=======================================================================================
+
+ResultStoreReader::ResultStoreReader(void)
+:
+	m_recordCount(0),
+	m_complete(false)
+{
+}
+
+ResultStoreReader::~ResultStoreReader(void)
+{
+	close();
+}
+
+bool ResultStoreReader::open(const QString &inFile)
+{
+	m_file.setFileName(inFile);
+	m_recordCount = 0;
+	m_complete = false;
+
+	if(!m_file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Failed to open result store: %s", inFile.toUtf8().constData());
+		return false;
+	}
+
+	m_stream.setDevice(&m_file);
+	m_stream.setVersion(QDataStream::Qt_4_8);
+
+	quint32 magic = 0, version = 0;
+	m_stream >> magic >> version;
+
+	if((m_stream.status() != QDataStream::Ok) || (magic != STORE_MAGIC) || (version != STORE_VERSION))
+	{
+		qWarning("Not a valid result store: %s", inFile.toUtf8().constData());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool ResultStoreReader::read(ResultStore::group_t &group)
+{
+	if((!m_file.isOpen()) || m_complete)
+	{
+		return false;
+	}
+
+	quint8 type = 0;
+	m_stream >> type;
+
+	if(type == RECORD_GROUP)
+	{
+		quint32 fileCount = 0;
+		group.hash.resize(HASH_SIZE);
+		group.files.clear();
+		m_stream >> group.size;
+		m_stream.readRawData(group.hash.data(), HASH_SIZE);
+		m_stream >> fileCount;
+		for(quint32 i = 0; (i < fileCount) && (m_stream.status() == QDataStream::Ok); i++)
+		{
+			QByteArray utf8Path;
+			m_stream >> utf8Path;
+			group.files << QString::fromUtf8(utf8Path.constData(), utf8Path.size());
+		}
+		if(m_stream.status() == QDataStream::Ok)
+		{
+			m_recordCount++;
+			return true;
+		}
+	}
+	else if(type == RECORD_EOF)
+	{
+		quint64 recordCount = 0;
+		m_stream >> recordCount;
+		m_complete = (m_stream.status() == QDataStream::Ok) && (recordCount == m_recordCount);
+		if(!m_complete)
+		{
+			qWarning("Result store is inconsistent: %s", m_file.fileName().toUtf8().constData());
+		}
+		return false;
+	}
+
+	qWarning("Result store is truncated: %s", m_file.fileName().toUtf8().constData());
+	return false;
+}
+
+bool ResultStoreReader::isComplete(void) const
+{
+	return m_complete;
+}
+
+void ResultStoreReader::close(void)
+{
+	if(m_file.isOpen())
+	{
+		m_stream.setDevice(NULL);
+		m_file.close();
+	}
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QFile>
+#include <QDataStream>
+
+//=======================================================================================
+
+/*
+ * The result store keeps the duplicate groups of a completed scan, sorted by their SHA-1
+ * digest. Because both the stored and the current groups are sorted, the changes between
+ * two runs are found by a single merge pass over both lists.
+ */
+
+class ResultStore
+{
+public:
+	typedef struct
+	{
+		QByteArray hash;
+		qint64 size;
+		QStringList files;
+	}
+	group_t;
+
+	//Change types
+	typedef enum
+	{
+		CHANGE_NONE     = 0,
+		CHANGE_NEW      = 1,
+		CHANGE_GROWN    = 2,
+		CHANGE_CHANGED  = 3,
+		CHANGE_RESOLVED = 4
+	}
+	changeType_t;
+
+	typedef struct
+	{
+		int changeType;
+		group_t group;
+		QStringList added;
+		QStringList removed;
+	}
+	change_t;
+
+	static void sortGroups(QList<group_t> &groups);
+	static bool save(const QString &outFile, const QList<group_t> &groups);
+	static bool diff(const QString &previousFile, const QList<group_t> &groups, QList<change_t> &changes);
+	static void diffGroup(const group_t &previous, const group_t &current, change_t &change);
+	static QString changeName(const int &changeType);
+
+private:
+	ResultStore(void) {}
+	~ResultStore(void) {}
+};
+
+//=======================================================================================
+
+class ResultStoreWriter
+{
+public:
+	ResultStoreWriter(void);
+	~ResultStoreWriter(void);
+
+	bool open(const QString &outFile);
+	bool write(const ResultStore::group_t &group);
+	bool close(void);
+
+protected:
+	QFile m_file;
+	QDataStream m_stream;
+	quint64 m_recordCount;
+};
+
+//=======================================================================================
+
+class ResultStoreReader
+{
+public:
+	ResultStoreReader(void);
+	~ResultStoreReader(void);
+
+	bool open(const QString &inFile);
+	bool read(ResultStore::group_t &group);
+	bool isComplete(void) const;
+	void close(void);
+
+protected:
+	QFile m_file;
+	QDataStream m_stream;
+	quint64 m_recordCount;
+	bool m_complete;
+};
@@ -0,0 +1,436 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ScanFilter.h"
+
+#include <QFile>
+#include <QDateTime>
+
+static const char CACHEDIR_TAG_NAME[] = "cachedir.tag";
+static const char CACHEDIR_TAG_SIGNATURE[] = "Signature: 8a477f597d28d172789f06886806bc55";
+
+static inline bool HAS_WILDCARDS(const QString &pattern)
+{
+	return pattern.contains(QLatin1Char('*')) || pattern.contains(QLatin1Char('?'));
+}
+
+/*translates a wildcard pattern into a regular expression, a '*' may match across path separators*/
+static QString WILDCARD_TO_REGEXP(const QString &pattern)
+{
+	QString regExp = QRegExp::escape(pattern);
+	regExp.replace(QLatin1String("\\*"), QLatin1String(".*"));
+	regExp.replace(QLatin1String("\\?"), QLatin1String("."));
+	return regExp;
+}
+
+static QString NORMALIZE_PATTERN(const QString &pattern)
+{
+	QString normalized = pattern.trimmed().toLower();
+	normalized.replace(QLatin1Char('\\'), QLatin1Char('/'));
+	return normalized;
+}
+
+//=======================================================================================
+// Pattern Set
+//=======================================================================================
+
+void ScanFilter::PatternSet::add(const QString &pattern)
+{
+	const QString normalized = NORMALIZE_PATTERN(pattern);
+	if(normalized.isEmpty() || m_patterns.contains(normalized))
+	{
+		return;
+	}
+
+	m_patterns << normalized;
+
+	if(!HAS_WILDCARDS(normalized))
+	{
+		m_exact.insert(normalized);
+	}
+	else if(normalized.startsWith(QLatin1String("*.")) && (!HAS_WILDCARDS(normalized.mid(1))))
+	{
+		m_suffixes.insert(normalized.mid(1));
+	}
+	else
+	{
+		m_wildcards << WILDCARD_TO_REGEXP(normalized);
+		m_combined = QRegExp(QString("^(?:%1)$").arg(m_wildcards.join(QLatin1String("|"))), Qt::CaseSensitive, QRegExp::RegExp2);
+	}
+}
+
+/*the text must have been converted to lower case already*/
+bool ScanFilter::PatternSet::matches(const QString &text) const
+{
+	if(m_exact.contains(text))
+	{
+		return true;
+	}
+
+	if(!m_suffixes.isEmpty())
+	{
+		for(int pos = text.indexOf(QLatin1Char('.')); pos >= 0; pos = text.indexOf(QLatin1Char('.'), pos + 1))
+		{
+			if(m_suffixes.contains(text.mid(pos)))
+			{
+				return true;
+			}
+		}
+	}
+
+	return (!m_wildcards.isEmpty()) && m_combined.exactMatch(text);
+}
+
+//=======================================================================================
+// Scan Filter
+//=======================================================================================
+
+ScanFilter::ScanFilter(void)
+:
+	m_excludeCaches(false),
+	m_minSize(-1),
+	m_maxSize(-1),
+	m_newerThan(-1),
+	m_olderThan(-1),
+	m_sameVolume(false)
+{
+}
+
+void ScanFilter::addExcludeName(const QString &pattern)
+{
+	m_excludeNames.add(pattern);
+}
+
+void ScanFilter::addIncludeName(const QString &pattern)
+{
+	m_includeNames.add(pattern);
+}
+
+void ScanFilter::addExcludePath(const QString &pattern)
+{
+	m_excludePaths.add(pattern);
+}
+
+void ScanFilter::addMarkerFile(const QString &fileName)
+{
+	const QString normalized = NORMALIZE_PATTERN(fileName);
+	if(!normalized.isEmpty())
+	{
+		m_markerFiles.insert(normalized);
+	}
+}
+
+void ScanFilter::setExcludeCaches(const bool &enabled)
+{
+	m_excludeCaches = enabled;
+}
+
+void ScanFilter::setSizeRange(const qint64 &minSize, const qint64 &maxSize)
+{
+	m_minSize = minSize;
+	m_maxSize = maxSize;
+}
+
+void ScanFilter::setTimeRange(const qint64 &newerThan, const qint64 &olderThan)
+{
+	m_newerThan = newerThan;
+	m_olderThan = olderThan;
+}
+
+void ScanFilter::setSameVolume(const bool &enabled)
+{
+	m_sameVolume = enabled;
+}
+
+void ScanFilter::addAllowedFileSystem(const QString &name)
+{
+	const QString normalized = name.trimmed().toLower();
+	if(!normalized.isEmpty())
+	{
+		m_allowedFileSystems.insert(normalized);
+	}
+}
+
+void ScanFilter::addDeniedFileSystem(const QString &name)
+{
+	const QString normalized = name.trimmed().toLower();
+	if(!normalized.isEmpty())
+	{
+		m_deniedFileSystems.insert(normalized);
+	}
+}
+
+bool ScanFilter::isEmpty(void) const
+{
+	return m_excludeNames.isEmpty() && m_includeNames.isEmpty() && m_excludePaths.isEmpty() && m_markerFiles.isEmpty() && (!m_excludeCaches) && (m_minSize < 0) && (m_maxSize < 0) && (m_newerThan < 0) && (m_olderThan < 0) && (!m_sameVolume) && (!hasVolumeRules());
+}
+
+bool ScanFilter::acceptDirectory(const QString &name, const QString &path) const
+{
+	if((!m_excludeNames.isEmpty()) && m_excludeNames.matches(name.toLower()))
+	{
+		return false;
+	}
+
+	return m_excludePaths.isEmpty() || (!m_excludePaths.matches(path.toLower()));
+}
+
+bool ScanFilter::acceptFile(const QString &name, const QString &path, const qint64 &size, const qint64 &mtime) const
+{
+	if(((m_minSize >= 0) && (size < m_minSize)) || ((m_maxSize >= 0) && (size > m_maxSize)))
+	{
+		return false;
+	}
+
+	if(((m_newerThan >= 0) && (mtime < m_newerThan)) || ((m_olderThan >= 0) && (mtime >= m_olderThan)))
+	{
+		return false;
+	}
+
+	if(!(m_excludeNames.isEmpty() && m_includeNames.isEmpty()))
+	{
+		const QString lowerName = name.toLower();
+		if(m_excludeNames.matches(lowerName) || ((!m_includeNames.isEmpty()) && (!m_includeNames.matches(lowerName))))
+		{
+			return false;
+		}
+	}
+
+	return m_excludePaths.isEmpty() || (!m_excludePaths.matches(path.toLower()));
+}
+
+/*a directory that contains a marker file is skipped along with all of its sub-directories*/
+bool ScanFilter::isMarker(const QString &name, const QString &path) const
+{
+	if(m_markerFiles.isEmpty() && (!m_excludeCaches))
+	{
+		return false;
+	}
+
+	const QString lowerName = name.toLower();
+
+	if(m_markerFiles.contains(lowerName))
+	{
+		return true;
+	}
+
+	if(m_excludeCaches && (lowerName == QLatin1String(CACHEDIR_TAG_NAME)))
+	{
+		QFile file(path);
+		if(file.open(QIODevice::ReadOnly))
+		{
+			const int signatureLen = int(sizeof(CACHEDIR_TAG_SIGNATURE)) - 1;
+			const QByteArray header = file.read(signatureLen);
+			file.close();
+			return (header == QByteArray(CACHEDIR_TAG_SIGNATURE, signatureLen));
+		}
+	}
+
+	return false;
+}
+
+/*a rule may name either the file system (e.g. "ntfs") or the drive type (e.g. "remote")*/
+bool ScanFilter::acceptVolume(const QString &fileSystem, const QString &driveType) const
+{
+	if(m_deniedFileSystems.contains(fileSystem) || m_deniedFileSystems.contains(driveType))
+	{
+		return false;
+	}
+
+	return m_allowedFileSystems.isEmpty() || m_allowedFileSystems.contains(fileSystem) || m_allowedFileSystems.contains(driveType);
+}
+
+/*the same rules, as command-line arguments for the worker processes*/
+QStringList ScanFilter::toArguments(void) const
+{
+	QStringList args;
+
+	for(QStringList::ConstIterator iter = m_excludeNames.patterns().constBegin(); iter != m_excludeNames.patterns().constEnd(); iter++)
+	{
+		args << "--exclude" << (*iter);
+	}
+	for(QStringList::ConstIterator iter = m_includeNames.patterns().constBegin(); iter != m_includeNames.patterns().constEnd(); iter++)
+	{
+		args << "--include" << (*iter);
+	}
+	for(QStringList::ConstIterator iter = m_excludePaths.patterns().constBegin(); iter != m_excludePaths.patterns().constEnd(); iter++)
+	{
+		args << "--exclude-path" << (*iter);
+	}
+	for(QSet<QString>::ConstIterator iter = m_markerFiles.constBegin(); iter != m_markerFiles.constEnd(); iter++)
+	{
+		args << "--exclude-marker" << (*iter);
+	}
+	if(m_excludeCaches)
+	{
+		args << "--exclude-caches";
+	}
+	if(m_sameVolume)
+	{
+		args << "--one-volume";
+	}
+	for(QSet<QString>::ConstIterator iter = m_allowedFileSystems.constBegin(); iter != m_allowedFileSystems.constEnd(); iter++)
+	{
+		args << "--fs-allow" << (*iter);
+	}
+	for(QSet<QString>::ConstIterator iter = m_deniedFileSystems.constBegin(); iter != m_deniedFileSystems.constEnd(); iter++)
+	{
+		args << "--fs-deny" << (*iter);
+	}
+	if(m_minSize >= 0)
+	{
+		args << "--min-size" << QString::number(m_minSize);
+	}
+	if(m_maxSize >= 0)
+	{
+		args << "--max-size" << QString::number(m_maxSize);
+	}
+	if(m_newerThan >= 0)
+	{
+		args << "--newer-than" << QDateTime::fromMSecsSinceEpoch(m_newerThan).toString(Qt::ISODate);
+	}
+	if(m_olderThan >= 0)
+	{
+		args << "--older-than" << QDateTime::fromMSecsSinceEpoch(m_olderThan).toString(Qt::ISODate);
+	}
+
+	return args;
+}
+
+/*applies the filter option at the given index, the index is moved past its value; returns false for any other option*/
+bool ScanFilter::parseArgument(const QStringList &args, int &index)
+{
+	const QString &current = args.at(index);
+	const bool hasValue = (index + 1 < args.count());
+
+	if(current.compare("--exclude-caches", Qt::CaseInsensitive) == 0)
+	{
+		m_excludeCaches = true;
+		return true;
+	}
+	if(current.compare("--one-volume", Qt::CaseInsensitive) == 0)
+	{
+		m_sameVolume = true;
+		return true;
+	}
+	if(!hasValue)
+	{
+		return false;
+	}
+
+	const QString &value = args.at(index + 1);
+	if(current.compare("--exclude", Qt::CaseInsensitive) == 0)
+	{
+		addExcludeName(value);
+	}
+	else if(current.compare("--include", Qt::CaseInsensitive) == 0)
+	{
+		addIncludeName(value);
+	}
+	else if(current.compare("--exclude-path", Qt::CaseInsensitive) == 0)
+	{
+		addExcludePath(value);
+	}
+	else if(current.compare("--exclude-marker", Qt::CaseInsensitive) == 0)
+	{
+		addMarkerFile(value);
+	}
+	else if((current.compare("--fs-allow", Qt::CaseInsensitive) == 0) || (current.compare("--fs-deny", Qt::CaseInsensitive) == 0))
+	{
+		const bool allow = (current.compare("--fs-allow", Qt::CaseInsensitive) == 0);
+		const QStringList names = value.split(',', QString::SkipEmptyParts);
+		for(QStringList::ConstIterator iter = names.constBegin(); iter != names.constEnd(); iter++)
+		{
+			if(allow)
+			{
+				addAllowedFileSystem(*iter);
+			}
+			else
+			{
+				addDeniedFileSystem(*iter);
+			}
+		}
+	}
+	else if(current.compare("--min-size", Qt::CaseInsensitive) == 0)
+	{
+		m_minSize = parseSize(value);
+	}
+	else if(current.compare("--max-size", Qt::CaseInsensitive) == 0)
+	{
+		m_maxSize = parseSize(value);
+	}
+	else if(current.compare("--newer-than", Qt::CaseInsensitive) == 0)
+	{
+		m_newerThan = parseTime(value);
+	}
+	else if(current.compare("--older-than", Qt::CaseInsensitive) == 0)
+	{
+		m_olderThan = parseTime(value);
+	}
+	else
+	{
+		return false;
+	}
+
+	index++;
+	return true;
+}
+
+/*accepts a number of bytes, optionally followed by a "K", "M" or "G" suffix*/
+qint64 ScanFilter::parseSize(const QString &text)
+{
+	QString number = text.trimmed().toUpper();
+	qint64 multiplier = 1;
+
+	if(number.endsWith(QLatin1Char('K')))
+	{
+		multiplier = 1024i64;
+	}
+	else if(number.endsWith(QLatin1Char('M')))
+	{
+		multiplier = 1048576i64;
+	}
+	else if(number.endsWith(QLatin1Char('G')))
+	{
+		multiplier = 1073741824i64;
+	}
+
+	if(multiplier > 1)
+	{
+		number.chop(1);
+	}
+
+	bool okay = false;
+	const qint64 value = number.toLongLong(&okay);
+	return (okay && (value >= 0)) ? (value * multiplier) : -1;
+}
+
+/*accepts an ISO 8601 date or date and time, returns milliseconds since the epoch*/
+qint64 ScanFilter::parseTime(const QString &text)
+{
+	QDateTime dateTime = QDateTime::fromString(text.trimmed(), Qt::ISODate);
+	if(!dateTime.isValid())
+	{
+		dateTime = QDateTime(QDate::fromString(text.trimmed(), Qt::ISODate));
+	}
+	return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : -1;
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QRegExp>
+
+//=======================================================================================
+
+/*
+ * Include/exclude rules that the directory scanner evaluates while walking the tree.
+ * Patterns without wildcards and plain "*.ext" patterns are looked up in hash sets;
+ * all other patterns of a set are compiled into one combined regular expression.
+ * Matching is case-insensitive, and an excluded directory is never opened. The volume
+ * rules decide whether the walk may continue onto another volume, e.g. a mounted drive.
+ */
+
+class ScanFilter
+{
+public:
+	ScanFilter(void);
+
+	void addExcludeName(const QString &pattern);
+	void addIncludeName(const QString &pattern);
+	void addExcludePath(const QString &pattern);
+	void addMarkerFile(const QString &fileName);
+	void setExcludeCaches(const bool &enabled);
+	void setSizeRange(const qint64 &minSize, const qint64 &maxSize);
+	void setTimeRange(const qint64 &newerThan, const qint64 &olderThan);
+	void setSameVolume(const bool &enabled);
+	void addAllowedFileSystem(const QString &name);
+	void addDeniedFileSystem(const QString &name);
+
+	bool isEmpty(void) const;
+	bool acceptDirectory(const QString &name, const QString &path) const;
+	bool acceptFile(const QString &name, const QString &path, const qint64 &size, const qint64 &mtime) const;
+	bool isMarker(const QString &name, const QString &path) const;
+	bool acceptVolume(const QString &fileSystem, const QString &driveType) const;
+
+	inline bool sameVolume(void) const     { return m_sameVolume; }
+	inline bool hasVolumeRules(void) const { return !(m_allowedFileSystems.isEmpty() && m_deniedFileSystems.isEmpty()); }
+	inline bool hasSizeRules(void) const   { return (m_minSize >= 0) || (m_maxSize >= 0); }
+	inline bool hasTimeRules(void) const   { return (m_newerThan >= 0) || (m_olderThan >= 0); }
+	inline bool hasMarkerRules(void) const { return (!m_markerFiles.isEmpty()) || m_excludeCaches; }
+
+	QStringList toArguments(void) const;
+	bool parseArgument(const QStringList &args, int &index);
+
+	static qint64 parseSize(const QString &text);
+	static qint64 parseTime(const QString &text);
+
+protected:
+	class PatternSet
+	{
+	public:
+		void add(const QString &pattern);
+		bool matches(const QString &text) const;
+		inline bool isEmpty(void) const { return m_patterns.isEmpty(); }
+		inline const QStringList &patterns(void) const { return m_patterns; }
+
+	protected:
+		QStringList m_patterns;
+		QSet<QString> m_exact;
+		QSet<QString> m_suffixes;
+		QStringList m_wildcards;
+		QRegExp m_combined;
+	};
+
+	PatternSet m_excludeNames;
+	PatternSet m_includeNames;
+	PatternSet m_excludePaths;
+	QSet<QString> m_markerFiles;
+	bool m_excludeCaches;
+
+	qint64 m_minSize;
+	qint64 m_maxSize;
+	qint64 m_newerThan;
+	qint64 m_olderThan;
+
+	bool m_sameVolume;
+	QSet<QString> m_allowedFileSystems;
+	QSet<QString> m_deniedFileSystems;
+};
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShardWorker.h"
+
+#include "Config.h"
+#include "System.h"
+#include "ScanFilter.h"
+#include "Thread_DirectoryScanner.h"
+#include "Thread_FileComparator.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+//=======================================================================================
+// Shard Worker
+//=======================================================================================
+
+int ShardWorker::run(const QStringList &args)
+{
+	volatile bool abortFlag = false;
+	const int threadCount = qBound(0, getEnvString("DBLSCAN_THREADS").toInt(), 64);
+
+	DirectoryScanner *directoryScanner = new DirectoryScanner(&abortFlag, threadCount);
+	FileComparator *fileComparator = new FileComparator(&abortFlag, threadCount);
+	ScanFilter filter;
+
+	QStringList directories;
+	QString partialOutput;
+	bool recursive = true, archives = false;
+
+	for(int i = 1; i < args.count(); i++)
+	{
+		const QString &current = args.at(i);
+		const bool hasValue = (i + 1 < args.count());
+
+		if((current.compare("--scan", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			QFileInfo folder(QDir::fromNativeSeparators(args.at(++i)));
+			if(folder.exists() && folder.isDir())
+			{
+				directories << folder.canonicalFilePath();
+			}
+		}
+		else if((current.compare("--partial-out", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			partialOutput = QDir::fromNativeSeparators(args.at(++i));
+		}
+		else if((current.compare("--shard", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			const QStringList shard = args.at(++i).split('/');
+			if(shard.count() == 2)
+			{
+				directoryScanner->setShard(shard.at(0).toUInt(), shard.at(1).toUInt());
+			}
+		}
+		else if((current.compare("--traversal", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			const QString order = args.at(++i).toLower();
+			directoryScanner->setTraversalOrder((order == "depth") ? DirectoryScanner::TRAVERSAL_DEPTH_FIRST : ((order == "breadth") ? DirectoryScanner::TRAVERSAL_BREADTH_FIRST : DirectoryScanner::TRAVERSAL_HYBRID));
+		}
+		else if((current.compare("--dir-cache", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			directoryScanner->setCacheFile(QDir::fromNativeSeparators(args.at(++i)));
+		}
+		else if(filter.parseArgument(args, i))
+		{
+			continue; /*one of the filter options*/
+		}
+		else if(current.compare("--no-recursive", Qt::CaseInsensitive) == 0)
+		{
+			recursive = false;
+		}
+		else if(current.compare("--archives", Qt::CaseInsensitive) == 0)
+		{
+			archives = true;
+		}
+	}
+
+	if(partialOutput.isEmpty())
+	{
+		qWarning("Worker process was started without \"--partial-out\", exiting!");
+		MY_DELETE(fileComparator);
+		MY_DELETE(directoryScanner);
+		return EXIT_FAILURE;
+	}
+
+	qDebug("Worker process is scanning %d directories.", directories.count());
+	QFile::remove(partialOutput);
+
+	/*both threads move themselves to their own thread, so they can simply be waited for*/
+	directoryScanner->setRecursive(recursive);
+	directoryScanner->setArchiveMode(archives);
+	directoryScanner->setFilter(filter);
+	directoryScanner->addDirectories(directories);
+	directoryScanner->start();
+	directoryScanner->wait();
+
+	fileComparator->setPartialOutput(partialOutput);
+	fileComparator->addFiles(directoryScanner->getFiles());
+	fileComparator->addMemberHashes(directoryScanner->getMemberHashes());
+	fileComparator->start();
+	fileComparator->wait();
+
+	MY_DELETE(fileComparator);
+	MY_DELETE(directoryScanner);
+
+	const bool okay = QFileInfo(partialOutput).isFile();
+	qDebug("Worker process is done, exiting.");
+
+	return okay ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QStringList>
+
+//=======================================================================================
+
+/*
+ * Runs the part of a sharded scan that was assigned to a worker process. The worker does
+ * not create any windows: it scans its roots (or its shard of the files), hashes the files
+ * and writes the partial result that the launching process merges later on.
+ */
+
+class ShardWorker
+{
+public:
+	static int run(const QStringList &args);
+
+private:
+	ShardWorker(void) {}
+	ShardWorker(const ShardWorker&) {}
+	ShardWorker &operator=(const ShardWorker&) { return *this; }
+};
@@ -24,17 +24,101 @@
 
 #include "Config.h"
 #include "System.h"
+#include "ArchiveReader.h"
+#include "DirectoryWalker.h"
 
 #include <QThreadPool>
 #include <QDir>
-#include <QDirIterator>
-#include <QEventLoop>
-#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QCryptographicHash>
 
-#include <cassert>
+#include <io.h>
+#include <fcntl.h>
 
-static const quint64 MAX_ENQUEUED_TASKS = 128;
-static const QStringList EMPTY_STRINGLIST;
+static const int HYBRID_QUEUE_LIMIT = 4096;
+static const int ENTRY_BATCH_SIZE = 16384;
+static const qint64 LIST_CHUNK_SIZE = 65536;
+static const QList<fileRecord_t> EMPTY_FILELIST;
+static const QHash<QString, QByteArray> EMPTY_HASHLIST;
+static const quint64 ZERO_COUNT = 0;
+
+static inline QString PARENT_DIRECTORY(const QString &path)
+{
+	const int pos = path.lastIndexOf('/', path.endsWith('/') ? -2 : -1);
+	if((pos > 0) && (path.at(pos - 1) == QLatin1Char(':')))
+	{
+		return path.left(pos + 1); /*keep the separator of a drive root*/
+	}
+	return (pos > 1) ? path.left(pos) : QString();
+}
+
+static inline bool IN_SHARD(const qint64 &size, const quint32 &shardIndex, const quint32 &shardCount)
+{
+	/*files of equal size always end up in the same shard*/
+	return (shardCount < 2) || ((qHash(quint64(size)) % shardCount) == shardIndex);
+}
+
+/*
+ * Lists the members of an archive as "virtual" files. The content is read only for compressed
+ * TAR files, which have to be inflated completely anyway, so their members are hashed right away
+ * and the comparator does not need to inflate them a second time.
+ */
+class ArchiveLister : public ArchiveReader::Handler
+{
+public:
+	ArchiveLister(const fileRecord_t &archive, QList<fileRecord_t> &files, QHash<QString, QByteArray> &memberHashes, const ScanFilter &filter, const quint32 &shardIndex, const quint32 &shardCount)
+	:
+		m_archive(archive), m_files(files), m_memberHashes(memberHashes), m_filter(filter), m_shardIndex(shardIndex), m_shardCount(shardCount),
+		m_hashing(ArchiveReader::isCompressed(archive.path)), m_hash(QCryptographicHash::Sha1)
+	{
+	}
+
+	virtual bool wantMember(const QString &name, const qint64 &size)
+	{
+		if(IN_SHARD(size, m_shardIndex, m_shardCount))
+		{
+			const QString memberPath = ArchiveReader::makePath(m_archive.path, name);
+			if(m_filter.acceptFile(name.mid(name.lastIndexOf('/') + 1), memberPath, size, m_archive.mtime))
+			{
+				m_files << MAKE_FILE_RECORD(memberPath, size, m_archive.mtime);
+				if(m_hashing)
+				{
+					m_currentPath = memberPath;
+					m_hash.reset();
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	virtual bool memberData(const char *data, const qint64 &len)
+	{
+		m_hash.addData(data, int(len));
+		return true;
+	}
+
+	virtual void memberDone(void)
+	{
+		/*a name that occurs more than once is ambiguous, such members are read again by the comparator*/
+		m_memberHashes.insert(m_currentPath, m_memberHashes.contains(m_currentPath) ? QByteArray() : m_hash.result());
+	}
+
+protected:
+	const fileRecord_t m_archive;
+	QList<fileRecord_t> &m_files;
+	QHash<QString, QByteArray> &m_memberHashes;
+	const ScanFilter &m_filter;
+	const quint32 m_shardIndex;
+	const quint32 m_shardCount;
+	const bool m_hashing;
+
+	QCryptographicHash m_hash;
+	QString m_currentPath;
+};
 
 //=======================================================================================
 // Directory Scanner
@@ -47,9 +131,14 @@ DirectoryScanner::DirectoryScanner(volatile bool *abortFlag, const int &threadCo
 {
 	this->moveToThread(this);
 
-	m_pendingTasks = 0;
 	m_pool = new QThreadPool();
+	m_fileCount = 0;
 	m_pauseFlag = false;
+	m_archives = false;
+	m_traversalOrder = TRAVERSAL_DEPTH_FIRST;
+
+	m_shardIndex = 0;
+	m_shardCount = 1;
 
 	if(threadCount > 0)
 	{
@@ -69,27 +158,74 @@ void DirectoryScanner::run(void)
 	//qWarning("DirectoryScanner::run: Current thread id = %u", getCurrentThread());
 
 	m_files.clear();
-	m_pendingTasks = 0;
+	m_memberHashes.clear();
+	m_fileCount = 0;
+	m_visited.clear();
+	m_cache.clear();
 
-	if(m_pendingDirs.count() < 1)
+	if((m_pendingDirs.count() < 1) && (m_fileLists.count() < 1))
 	{
 		qWarning("File list is empty -> Nothing to do!");
 		return;
 	}
 
+	/*listed files are taken as they are, no directory is walked for them*/
+	const bool hasFileLists = (!m_fileLists.isEmpty());
+	while((!m_fileLists.isEmpty()) && (!(*m_abortFlag)))
+	{
+		const QString listFile = m_fileLists.takeFirst();
+		if(!readFileList(listFile))
+		{
+			qWarning("Failed to read file list: %s", listFile.toUtf8().constData());
+		}
+	}
+	m_fileLists.clear();
+
+	/*only the roots are canonicalized, the paths below them are built from the directory entries*/
+	for(QQueue<QString>::Iterator iter = m_pendingDirs.begin(); iter != m_pendingDirs.end();)
+	{
+		const QString canonicalPath = QFileInfo(*iter).canonicalFilePath();
+		if(!canonicalPath.isEmpty())
+		{
+			(*iter) = canonicalPath;
+		}
+		QString fileSystem, driveType;
+		if(m_filter.hasVolumeRules() && DirectoryWalker::volumeType(*iter, fileSystem, driveType) && (!m_filter.acceptVolume(fileSystem, driveType)))
+		{
+			qWarning("Skipping %s, file system \"%s\" (%s) is excluded!", iter->toUtf8().constData(), fileSystem.toUtf8().constData(), driveType.toUtf8().constData());
+			iter = m_pendingDirs.erase(iter);
+			continue;
+		}
+		iter++;
+	}
+
+	const QStringList roots = pruneRoots(m_pendingDirs, m_recusrive);
+	m_pendingDirs.clear();
+	m_pendingDirs << roots;
+
 	qDebug("Pending dirs: %d", m_pendingDirs.count());
 
-	while((!m_pendingDirs.empty()) && (m_pendingTasks < MAX_ENQUEUED_TASKS))
+	if(!m_cacheFile.isEmpty())
 	{
-		scanDirectory(m_pendingDirs.dequeue());
+		m_cache.load(m_cacheFile);
 	}
 
-	exec();
+	/*the roots are dealt out round-robin, everything found below them stays with the worker that found it, until it is stolen*/
+	const int workerCount = qBound(1, m_pool->maxThreadCount(), 64);
+	WorkQueues queues(workerCount, m_traversalOrder);
 
-	if(!m_pendingDirs.empty())
+	for(int i = 0; !m_pendingDirs.empty(); i = (i + 1) % workerCount)
 	{
-		qWarning("Thread is about to exit while there still are pending directories!");
-		m_pendingDirs.clear();
+		queues.push(i, m_pendingDirs.dequeue());
+	}
+
+	QList<DirectoryScannerTask*> workers;
+	for(int i = 0; i < workerCount; i++)
+	{
+		DirectoryScannerTask *worker = new DirectoryScannerTask(i, &queues, this);
+		worker->setAutoDelete(false);
+		workers << worker;
+		m_pool->start(worker);
 	}
 
 	while(!m_pool->waitForDone(5000))
@@ -97,49 +233,131 @@ void DirectoryScanner::run(void)
 		qWarning("Still have running taks -> waiting for completeion!");
 	}
 
-	qDebug("Found %d files!", m_files.count());
+	qDebug("Peak number of queued directories and batches: %d", queues.peakLength());
+
+	/*each worker collected its files in a buffer of its own, so they are only merged once at the end*/
+	QList<fileRecord_t> linkedFiles;
+	while(!workers.isEmpty())
+	{
+		DirectoryScannerTask *worker = workers.takeFirst();
+		m_files << worker->getFiles();
+		linkedFiles << worker->getLinkedFiles();
+		m_memberHashes.unite(worker->getMemberHashes()); /*each archive is listed by a single worker*/
+		MY_DELETE(worker);
+	}
+
+	/*
+	 * Directories are visited only once, so only files reached via a link or given in a list can
+	 * have been found twice. A file that is found twice would be reported as its own duplicate.
+	 */
+	if(hasFileLists || (!linkedFiles.isEmpty()))
+	{
+		m_files << linkedFiles;
+		QList<fileRecord_t> files;
+		QSet<QString> knownPaths;
+		for(QList<fileRecord_t>::ConstIterator iter = m_files.constBegin(); iter != m_files.constEnd(); iter++)
+		{
+			const QString key = iter->path.toCaseFolded();
+			if(!knownPaths.contains(key))
+			{
+				knownPaths.insert(key);
+				files << (*iter);
+			}
+		}
+		qDebug("Skipping %d file(s) that have been found twice.", m_files.count() - files.count());
+		m_files.swap(files);
+	}
+
+	m_fileCount = m_files.count();
+
+	/*an aborted scan has not seen every directory, so it must not replace the cache*/
+	if((!m_cacheFile.isEmpty()) && (!(*m_abortFlag)))
+	{
+		if(!m_cache.save(m_cacheFile))
+		{
+			qWarning("Failed to write directory cache: %s", m_cacheFile.toUtf8().constData());
+		}
+	}
+	m_cache.clear();
+	qDebug("Found %u files!", quint32(m_fileCount));
 	qDebug("Thread will exit!\n");
 }
 
-void DirectoryScanner::scanDirectory(const QString path)
+void DirectoryScanner::addDirectory(const QString &path)
 {
-	sleepWhilePaused();
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_pendingDirs << path;
+}
 
-	DirectoryScannerTask *task = new DirectoryScannerTask(path, m_abortFlag);
-	if(connect(task, SIGNAL(directoryAnalyzed(const QStringList*, const QStringList*)), this, SLOT(directoryDone(const QStringList*, const QStringList*)), Qt::BlockingQueuedConnection))
+void DirectoryScanner::addDirectories(const QStringList &paths)
+{
+	if(this->isRunning())
 	{
-		m_pendingTasks++;
-		m_pool->start(task);
+		qWarning("Cannot add input while thread is still running!");
+		return;
 	}
+
+	m_pendingDirs << paths;
 }
 
-void DirectoryScanner::directoryDone(const QStringList *files, const QStringList *dirs)
+/*"-" reads the list from the standard input*/
+void DirectoryScanner::addFileLists(const QStringList &listFiles)
 {
-	for(QStringList::ConstIterator iter = files->constBegin(); iter != files->constEnd(); iter++)
+	if(this->isRunning())
 	{
-		m_files.insert(*iter);
+		qWarning("Cannot add input while thread is still running!");
+		return;
 	}
 
-	if(m_recusrive)
+	m_fileLists << listFiles;
+}
+
+void DirectoryScanner::setRecursive(const bool &recusrive)
+{
+	if(this->isRunning())
 	{
-		m_pendingDirs << (*dirs);
+		qWarning("Cannot add input while thread is still running!");
+		return;
 	}
 
-	while((!m_pendingDirs.empty()) && (m_pendingTasks < MAX_ENQUEUED_TASKS) && (!(*m_abortFlag)))
+	m_recusrive = recusrive;
+}
+
+void DirectoryScanner::setTraversalOrder(const int &order)
+{
+	if(this->isRunning())
 	{
-		scanDirectory(m_pendingDirs.dequeue());
+		qWarning("Cannot add input while thread is still running!");
+		return;
 	}
 
-	assert(m_pendingTasks > 0);
+	m_traversalOrder = order;
+}
+
+void DirectoryScanner::setShard(const quint32 &index, const quint32 &count)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
 
-	if(--m_pendingTasks == 0)
+	if((count < 1) || (index >= count))
 	{
-		qDebug("All tasks done!");
-		QTimer::singleShot(0, this, SLOT(quit()));
+		qWarning("Invalid shard %u/%u specified, ignoring!", index, count);
+		return;
 	}
+
+	m_shardIndex = index;
+	m_shardCount = count;
 }
 
-void DirectoryScanner::addDirectory(const QString &path)
+void DirectoryScanner::setArchiveMode(const bool &enabled)
 {
 	if(this->isRunning())
 	{
@@ -147,10 +365,10 @@ void DirectoryScanner::addDirectory(const QString &path)
 		return;
 	}
 
-	m_pendingDirs << path;
+	m_archives = enabled;
 }
 
-void DirectoryScanner::addDirectories(const QStringList &paths)
+void DirectoryScanner::setCacheFile(const QString &cacheFile)
 {
 	if(this->isRunning())
 	{
@@ -158,10 +376,10 @@ void DirectoryScanner::addDirectories(const QStringList &paths)
 		return;
 	}
 
-	m_pendingDirs << paths;
+	m_cacheFile = cacheFile;
 }
 
-void DirectoryScanner::setRecursive(const bool &recusrive)
+void DirectoryScanner::setFilter(const ScanFilter &filter)
 {
 	if(this->isRunning())
 	{
@@ -169,21 +387,240 @@ void DirectoryScanner::setRecursive(const bool &recusrive)
 		return;
 	}
 
-	m_recusrive = recusrive;
+	m_filter = filter;
+}
+
+/*
+ * Drops every root that equals or lies inside another root, also if one of them is reached via
+ * a link, junction or mount point. Without recursion a nested root is not covered by its parent,
+ * so then only equal roots are dropped.
+ */
+QStringList DirectoryScanner::pruneRoots(const QList<QString> &roots, const bool &recursive)
+{
+	QList<QPair<quint32, quint64> > rootIds;
+	QList<bool> identified;
+	QStringList cleanRoots;
+
+	for(QList<QString>::ConstIterator iter = roots.constBegin(); iter != roots.constEnd(); iter++)
+	{
+		quint32 volume = 0;
+		quint64 fileIndex = 0;
+		cleanRoots << QDir::cleanPath(*iter);
+		identified << (DirectoryWalker::identify(cleanRoots.last(), volume, fileIndex) && (fileIndex != 0));
+		rootIds << qMakePair(volume, fileIndex);
+	}
+
+	QStringList result;
+	for(int i = 0; i < cleanRoots.count(); i++)
+	{
+		int coveredBy = -1;
+		for(QString current = cleanRoots.at(i); (!current.isEmpty()) && (coveredBy < 0); current = recursive ? PARENT_DIRECTORY(current) : QString())
+		{
+			quint32 volume = 0;
+			quint64 fileIndex = 0;
+			const bool isRoot = (current == cleanRoots.at(i));
+			const bool currentIdentified = isRoot ? identified.at(i) : (DirectoryWalker::identify(current, volume, fileIndex) && (fileIndex != 0));
+			const QPair<quint32, quint64> currentId = isRoot ? rootIds.at(i) : qMakePair(volume, fileIndex);
+			for(int j = 0; (j < cleanRoots.count()) && (coveredBy < 0); j++)
+			{
+				/*of two equal roots only the first one is kept*/
+				if((j == i) || (isRoot && (j > i)))
+				{
+					continue;
+				}
+				if((current.compare(cleanRoots.at(j), Qt::CaseInsensitive) == 0) || (currentIdentified && identified.at(j) && (currentId == rootIds.at(j))))
+				{
+					coveredBy = j;
+				}
+			}
+		}
+		if(coveredBy >= 0)
+		{
+			qDebug("Skipping %s, it is already covered by %s", cleanRoots.at(i).toUtf8().constData(), cleanRoots.at(coveredBy).toUtf8().constData());
+			continue;
+		}
+		result << cleanRoots.at(i);
+	}
+
+	return result;
+}
+
+/*entries are separated by NUL characters, if the list contains any, or by line breaks otherwise*/
+bool DirectoryScanner::readFileList(const QString &listFile)
+{
+	QFile file;
+	const bool isStdin = (listFile.compare("-") == 0);
+	if(!isStdin)
+	{
+		file.setFileName(listFile);
+	}
+
+	if(isStdin)
+	{
+		_setmode(_fileno(stdin), _O_BINARY); /*a NUL-separated list must not be altered by text mode*/
+	}
+
+	if(!(isStdin ? file.open(stdin, QIODevice::ReadOnly) : file.open(QIODevice::ReadOnly)))
+	{
+		return false;
+	}
+
+	qDebug("Reading file list: %s", isStdin ? "<stdin>" : listFile.toUtf8().constData());
+
+	QSet<QString> knownPaths;
+	QByteArray pending;
+	char separator = '\0';
+	bool detected = false, endOfList = false;
+	int entryCount = 0;
+
+	while(!(endOfList || (*m_abortFlag)))
+	{
+		sleepWhilePaused();
+
+		const QByteArray chunk = file.read(LIST_CHUNK_SIZE);
+		endOfList = chunk.isEmpty();
+		pending.append(chunk);
+
+		if(!detected)
+		{
+			detected = pending.contains('\0') || pending.contains('\n') || endOfList;
+			separator = pending.contains('\0') ? '\0' : '\n';
+			if(!detected)
+			{
+				continue;
+			}
+		}
+
+		int start = 0;
+		for(int pos = pending.indexOf(separator); (pos >= 0) || (endOfList && (start < pending.size())); pos = pending.indexOf(separator, start))
+		{
+			const int end = (pos >= 0) ? pos : pending.size();
+			fileRecord_t record;
+			if(acceptListEntry(pending.mid(start, end - start), record) && (!knownPaths.contains(record.path.toCaseFolded())))
+			{
+				knownPaths.insert(record.path.toCaseFolded());
+				if(IN_SHARD(record.size, m_shardIndex, m_shardCount))
+				{
+					m_files << record;
+				}
+				if(m_archives && ArchiveReader::isArchive(record.path))
+				{
+					ArchiveLister lister(record, m_files, m_memberHashes, m_filter, m_shardIndex, m_shardCount);
+					ArchiveReader::process(record.path, &lister);
+				}
+				entryCount++;
+			}
+			start = end + 1;
+		}
+		pending.remove(0, qMin(start, pending.size()));
+	}
+
+	const bool okay = (file.error() == QFile::NoError);
+	file.close();
+
+	qDebug("Found %d listed files.", entryCount);
+	return okay;
 }
 
-const QStringList DirectoryScanner::getFiles(void) const
+/*an entry is either a path or a size in bytes, followed by a tab character and the path*/
+bool DirectoryScanner::acceptListEntry(const QByteArray &line, fileRecord_t &record)
+{
+	QString text = QString::fromUtf8(line.constData(), line.size());
+	if(text.endsWith('\r'))
+	{
+		text.chop(1);
+	}
+
+	qint64 size = -1, mtime = 0;
+	const int tab = text.indexOf('\t');
+	if(tab > 0)
+	{
+		bool okay = false;
+		const qint64 value = text.left(tab).toLongLong(&okay);
+		if(okay && (value >= 0))
+		{
+			size = value;
+			text = text.mid(tab + 1);
+		}
+	}
+
+	if(text.trimmed().isEmpty())
+	{
+		return false;
+	}
+
+	/*relative paths and ".." are resolved without touching the file system, links are not*/
+	const QString path = QDir::cleanPath(QFileInfo(QDir::fromNativeSeparators(text)).absoluteFilePath());
+	const int namePos = path.lastIndexOf('/');
+	const QString name = path.mid(namePos + 1);
+
+	/*without a size the file is only examined where needed, otherwise it is left to the comparator*/
+	if(((size < 0) && (m_filter.hasSizeRules() || (m_shardCount > 1))) || m_filter.hasTimeRules())
+	{
+		const QFileInfo info(path);
+		if(!(info.exists() && info.isFile()))
+		{
+			return false;
+		}
+		size = (size < 0) ? info.size() : size;
+		mtime = info.lastModified().toMSecsSinceEpoch();
+	}
+
+	if(!m_filter.isEmpty())
+	{
+		if(m_filter.isMarker(name, path) || (!m_filter.acceptFile(name, path, size, mtime)))
+		{
+			return false;
+		}
+		/*the directories that contain the file must pass the filter as well*/
+		for(int start = path.indexOf('/') + 1; (start > 0) && (start < namePos);)
+		{
+			const int pos = path.indexOf('/', start);
+			if(!m_filter.acceptDirectory(path.mid(start, pos - start), path.left(pos)))
+			{
+				return false;
+			}
+			start = pos + 1;
+		}
+	}
+
+	record = MAKE_FILE_RECORD(path, size, mtime);
+	return true;
+}
+
+/*the result is shared, not copied, and it is left unsorted; consumers that need an order sort it themselves*/
+const QList<fileRecord_t> &DirectoryScanner::getFiles(void) const
 {
 	if(this->isRunning())
 	{
 		qWarning("Result requested while thread is still running!");
-		return EMPTY_STRINGLIST;
+		return EMPTY_FILELIST;
 	}
 
-	QStringList fileList = m_files.values();
+	return m_files;
+}
 
-	fileList.sort();
-	return fileList;
+/*digests of the archive members that have already been read while they were listed*/
+const QHash<QString, QByteArray> &DirectoryScanner::getMemberHashes(void) const
+{
+	if(this->isRunning())
+	{
+		qWarning("Result requested while thread is still running!");
+		return EMPTY_HASHLIST;
+	}
+
+	return m_memberHashes;
+}
+
+const quint64 &DirectoryScanner::getFileCount(void) const
+{
+	if(this->isRunning())
+	{
+		qWarning("Result requested while thread is still running!");
+		return ZERO_COUNT;
+	}
+
+	return m_fileCount;
 }
 
 void DirectoryScanner::suspend(const bool bSuspend)
@@ -207,14 +644,227 @@ void DirectoryScanner::sleepWhilePaused(void)
 	m_pauseLock.unlock();
 }
 
+//=======================================================================================
+// Visited Directories
+//=======================================================================================
+
+/*
+ * A directory without a usable file index (zero, or on a file system that does not keep
+ * the index stable, e.g. FAT or some network shares) is recognized by its path only.
+ */
+bool VisitedDirectories::insert(const QString &directory, const bool &identified, const quint32 &volume, const quint64 &fileIndex)
+{
+	QMutexLocker lock(&m_lock);
+
+	if(identified && (fileIndex != 0) && hasStableIndex(directory, volume))
+	{
+		const QPair<quint32, quint64> key(volume, fileIndex);
+		if(m_visited.contains(key))
+		{
+			return false;
+		}
+		m_visited.insert(key);
+		return true;
+	}
+
+	const QString key = QDir::cleanPath(directory).toLower();
+	if(m_visitedPaths.contains(key))
+	{
+		return false;
+	}
+	m_visitedPaths.insert(key);
+	return true;
+}
+
+void VisitedDirectories::clear(void)
+{
+	QMutexLocker lock(&m_lock);
+	m_visited.clear();
+	m_visitedPaths.clear();
+	m_stableVolumes.clear();
+}
+
+/*the file system of each volume is looked up only once, the caller holds the lock*/
+bool VisitedDirectories::hasStableIndex(const QString &directory, const quint32 &volume)
+{
+	QHash<quint32, bool>::ConstIterator iter = m_stableVolumes.constFind(volume);
+	if(iter != m_stableVolumes.constEnd())
+	{
+		return iter.value();
+	}
+
+	QString fileSystem, driveType;
+	bool stable = false;
+	if(DirectoryWalker::volumeType(directory, fileSystem, driveType))
+	{
+		stable = (!fileSystem.contains("fat")) && (driveType != QLatin1String("remote"));
+	}
+
+	m_stableVolumes.insert(volume, stable);
+	return stable;
+}
+
+//=======================================================================================
+// Work Queues
+//=======================================================================================
+
+WorkQueues::WorkQueues(const int &count, const int &order)
+:
+	m_count(qMax(1, count)),
+	m_order(order),
+	m_pending(0),
+	m_queued(0),
+	m_peak(0)
+{
+	for(int i = 0; i < m_count; i++)
+	{
+		m_queues << new queue_t;
+	}
+}
+
+WorkQueues::~WorkQueues(void)
+{
+	while(!m_queues.isEmpty())
+	{
+		queue_t *queue = m_queues.takeFirst();
+		MY_DELETE(queue);
+	}
+}
+
+void WorkQueues::push(const int &owner, const QString &directory)
+{
+	item_t item;
+	item.directory = directory;
+	item.volume = 0;
+	item.identified = false;
+	item.isBatch = false;
+	pushItem(owner, item);
+}
+
+void WorkQueues::pushBatch(const int &owner, const QString &directory, const QList<DirectoryWalker::entry_t> &entries, const quint32 &volume, const bool &identified)
+{
+	item_t item;
+	item.directory = directory;
+	item.entries = entries;
+	item.volume = volume;
+	item.identified = identified;
+	item.isBatch = true;
+	pushItem(owner, item);
+}
+
+void WorkQueues::pushItem(const int &owner, const item_t &item)
+{
+	m_pending.ref();
+
+	queue_t *const queue = m_queues.at(owner % m_count);
+	queue->lock.lock();
+	queue->items.append(item);
+	queue->lock.unlock();
+
+	const int queued = m_queued.fetchAndAddOrdered(1) + 1;
+	for(int peak = m_peak; (queued > peak) && (!m_peak.testAndSetOrdered(peak, queued)); peak = m_peak)
+	{
+		/*retry until the peak is updated or another thread has set a higher one*/
+	}
+
+	/*the lock ensures that an idle worker either sees the new item or is already waiting for it*/
+	QMutexLocker lock(&m_idleLock);
+	m_idleWait.wakeOne();
+}
+
+bool WorkQueues::pop(const int &owner, item_t &item, volatile bool *abortFlag)
+{
+	forever
+	{
+		if(*abortFlag)
+		{
+			QMutexLocker lock(&m_idleLock);
+			m_idleWait.wakeAll(); /*idle workers must notice the abort, too*/
+			return false;
+		}
+
+		/*the own queue is used from the back, which keeps a worker close to where it just was, or from the front*/
+		queue_t *const ownQueue = m_queues.at(owner % m_count);
+		ownQueue->lock.lock();
+		if(!ownQueue->items.isEmpty())
+		{
+			item = takeFromBack() ? ownQueue->items.takeLast() : ownQueue->items.takeFirst();
+			ownQueue->lock.unlock();
+			m_queued.deref();
+			return true;
+		}
+		ownQueue->lock.unlock();
+
+		/*the other queues are robbed from the front, where the biggest subtrees usually are*/
+		for(int i = 1; i < m_count; i++)
+		{
+			queue_t *const queue = m_queues.at((owner + i) % m_count);
+			queue->lock.lock();
+			if(!queue->items.isEmpty())
+			{
+				item = queue->items.takeFirst();
+				queue->lock.unlock();
+				m_queued.deref();
+				return true;
+			}
+			queue->lock.unlock();
+		}
+
+		/*nothing is queued and no directory is in progress, so nothing can turn up anymore*/
+		if(int(m_pending) == 0)
+		{
+			return false;
+		}
+
+		/*sleep until an item is pushed, the last directory is done or the scan is aborted*/
+		m_idleLock.lock();
+		if((int(m_queued) == 0) && (int(m_pending) != 0) && (!(*abortFlag)))
+		{
+			m_idleWait.wait(&m_idleLock);
+		}
+		m_idleLock.unlock();
+	}
+}
+
+/*depth-first keeps only the siblings along the current paths queued, breadth-first keeps the whole frontier*/
+bool WorkQueues::takeFromBack(void) const
+{
+	switch(m_order)
+	{
+	case DirectoryScanner::TRAVERSAL_BREADTH_FIRST:
+		return false;
+	case DirectoryScanner::TRAVERSAL_HYBRID:
+		return (int(m_queued) >= HYBRID_QUEUE_LIMIT);
+	}
+	return true;
+}
+
+void WorkQueues::done(void)
+{
+	if(!m_pending.deref())
+	{
+		QMutexLocker lock(&m_idleLock);
+		m_idleWait.wakeAll();
+	}
+}
+
 //=======================================================================================
 // Directory Scanner Task
 //=======================================================================================
 
-DirectoryScannerTask::DirectoryScannerTask(const QString &directory, volatile bool *abortFlag)
+DirectoryScannerTask::DirectoryScannerTask(const int &index, WorkQueues *queues, DirectoryScanner *scanner)
 :
-	m_directory(directory),
-	m_abortFlag(abortFlag)
+	m_index(index),
+	m_recursive(scanner->m_recusrive),
+	m_shardIndex(scanner->m_shardIndex),
+	m_shardCount(scanner->m_shardCount),
+	m_archives(scanner->m_archives),
+	m_filter(scanner->m_filter),
+	m_cache(scanner->m_cacheFile.isEmpty() ? NULL : &scanner->m_cache),
+	m_queues(queues),
+	m_scanner(scanner),
+	m_visited(&scanner->m_visited),
+	m_abortFlag(scanner->m_abortFlag)
 {
 }
 
@@ -225,39 +875,245 @@ DirectoryScannerTask::~DirectoryScannerTask(void)
 
 void DirectoryScannerTask::run(void)
 {
-	qDebug("%s", m_directory.toUtf8().constData());
+	WorkQueues::item_t item;
+
+	while(m_queues->pop(m_index, item, m_abortFlag))
+	{
+		m_scanner->sleepWhilePaused();
+		if(item.isBatch)
+		{
+			classifyEntries(item.directory, item.entries, item.volume, item.identified);
+		}
+		else
+		{
+			scanDirectory(item.directory);
+		}
+		m_queues->done();
+	}
+}
+
+void DirectoryScannerTask::scanDirectory(const QString &directory)
+{
+	qDebug("%s", directory.toUtf8().constData());
+
+	/*prune a directory that was reached before, e.g. via a junction or an overlapping root*/
+	quint32 volume = 0;
+	quint64 fileIndex = 0;
+	qint64 dirMtime = 0, dirCtime = 0;
+	const bool identified = DirectoryWalker::identify(directory, volume, fileIndex, &dirMtime, &dirCtime);
+	if(!m_visited->insert(directory, identified, volume, fileIndex))
+	{
+		qDebug("Skipped, already visited: %s", directory.toUtf8().constData());
+		return;
+	}
 
-	QStringList files, dirs;
-	QFileInfo dirInfo(m_directory);
-	
-	if((*m_abortFlag) || (!(dirInfo.exists() && dirInfo.isDir())))
+	/*an unchanged directory is not listed again, its sub-directories are still visited and checked on their own*/
+	QList<DirectoryWalker::entry_t> cached;
+	const bool useCache = (m_cache != NULL) && identified;
+	const bool fromCache = useCache && m_cache->lookup(directory, dirMtime, dirCtime, cached);
+	const bool fillCache = useCache && (!fromCache);
+	DirectoryWalker *walker = fromCache ? NULL : new DirectoryWalker(directory);
+	if((*m_abortFlag) || (walker && (!walker->isOpen())))
 	{
-		emit directoryAnalyzed(&files, &dirs);
+		MY_DELETE(walker);
 		return;
 	}
 
-	QDirIterator iter(m_directory, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden, QDirIterator::NoIteratorFlags);
+	/*
+	 * The first entries are classified by this task, every further batch is queued as soon as it is complete, so idle
+	 * workers can take it over while the directory is still being listed. A marker file excludes the whole directory,
+	 * but a batch that another worker has taken can not be withdrawn anymore. So if there are marker rules, the batches
+	 * are held back until the listing is done; without such rules no entry can ever turn out to be a marker.
+	 */
+	const QString prefix = directory.endsWith('/') ? directory : (directory + '/');
+	const bool holdBatches = m_filter.hasMarkerRules();
+	QList<DirectoryWalker::entry_t> entries, batch, listing;
+	QList<QList<DirectoryWalker::entry_t> > heldBatches;
+	QList<DirectoryWalker::entry_t>::ConstIterator cachedIter = cached.constBegin();
+	DirectoryWalker::entry_t entry;
+	bool markerFound = false;
+	int batchCount = 0;
 
-	while(iter.hasNext() && (!(*m_abortFlag)))
+	while((!(*m_abortFlag)) && (!(markerFound && (!fillCache))))
 	{
-		const QString path = iter.next();
-		const QFileInfo info = iter.fileInfo();
+		if(walker)
+		{
+			if(!walker->next(entry))
+			{
+				break;
+			}
+			if(fillCache)
+			{
+				listing << entry; /*the cache is filled with the complete listing, even if a marker file was found*/
+			}
+		}
+		else
+		{
+			if(cachedIter == cached.constEnd())
+			{
+				break;
+			}
+			entry = *(cachedIter++);
+		}
+
+		if(markerFound)
+		{
+			continue;
+		}
+		if((!DirectoryWalker::isDirectory(entry)) && m_filter.isMarker(entry.name, prefix + entry.name))
+		{
+			qDebug("Skipped, marker file found: %s", (prefix + entry.name).toUtf8().constData());
+			markerFound = true;
+			continue;
+		}
 
-		if(info.exists())
+		((entries.count() < ENTRY_BATCH_SIZE) ? entries : batch) << entry;
+		if(batch.count() >= ENTRY_BATCH_SIZE)
 		{
-			if(info.isFile())
+			if(holdBatches)
 			{
-				files << info.canonicalFilePath();
+				heldBatches << batch;
 			}
-			else if(info.isDir())
+			else
 			{
-				dirs << info.canonicalFilePath();
+				m_queues->pushBatch(m_index, directory, batch, volume, identified);
 			}
+			batch.clear();
+			batchCount++;
 		}
 	}
 
-	files.sort();
-	dirs.sort();
+	MY_DELETE(walker);
+
+	if(*m_abortFlag)
+	{
+		return;
+	}
+
+	if(fillCache)
+	{
+		m_cache->update(directory, dirMtime, dirCtime, listing);
+	}
+
+	if(markerFound)
+	{
+		return;
+	}
+
+	if(!batch.isEmpty())
+	{
+		heldBatches << batch;
+		batchCount++;
+	}
+	while(!heldBatches.isEmpty())
+	{
+		m_queues->pushBatch(m_index, directory, heldBatches.takeFirst(), volume, identified);
+	}
+	if(batchCount > 0)
+	{
+		qDebug("Split into %d additional batches: %s", batchCount, directory.toUtf8().constData());
+	}
+
+	classifyEntries(directory, entries, volume, identified);
+}
+
+void DirectoryScannerTask::classifyEntries(const QString &directory, const QList<DirectoryWalker::entry_t> &entries, const quint32 &volume, const bool &identified)
+{
+	const QString prefix = directory.endsWith('/') ? directory : (directory + '/');
+	QList<fileRecord_t> files, linkedFiles;
+	QStringList dirs;
+
+	for(QList<DirectoryWalker::entry_t>::ConstIterator iter = entries.constBegin(); (iter != entries.constEnd()) && (!(*m_abortFlag)); iter++)
+	{
+		const DirectoryWalker::entry_t &entry = (*iter);
+		QString path = prefix + entry.name;
+		bool isDir = DirectoryWalker::isDirectory(entry);
+		const bool isLink = DirectoryWalker::isLink(entry);
+		qint64 size = entry.size, mtime = entry.mtime;
+
+		if(isLink)
+		{
+			/*only links need to be resolved, everything else is found under its real path already*/
+			const QFileInfo info(path);
+			if(!(info.exists() && (info.isFile() || info.isDir())))
+			{
+				continue;
+			}
+			path = info.canonicalFilePath();
+			isDir = info.isDir();
+			size = info.size();
+			mtime = info.lastModified().toMSecsSinceEpoch();
+			if(isDir && identified && (!acceptVolume(path, volume)))
+			{
+				continue;
+			}
+		}
+
+		if(!isDir)
+		{
+			if(!m_filter.acceptFile(entry.name, path, size, mtime))
+			{
+				continue;
+			}
+			const fileRecord_t record = MAKE_FILE_RECORD(path, size, mtime, entry.attributes);
+			QList<fileRecord_t> &target = (isLink || (!identified)) ? linkedFiles : files;
+			if(IN_SHARD(size, m_shardIndex, m_shardCount))
+			{
+				target << record;
+			}
+			if(m_archives && ArchiveReader::isArchive(path))
+			{
+				ArchiveLister lister(record, target, m_memberHashes, m_filter, m_shardIndex, m_shardCount);
+				ArchiveReader::process(path, &lister);
+			}
+		}
+		else if(m_filter.acceptDirectory(entry.name, path))
+		{
+			dirs << path;
+		}
+	}
+
+	m_files << files;
+	m_linkedFiles << linkedFiles;
+
+	if(m_recursive)
+	{
+		/*pushed in reverse order, so that a depth-first traversal hands them out in sorted order again*/
+		dirs.sort();
+		for(int i = dirs.count() - 1; i >= 0; i--)
+		{
+			m_queues->push(m_index, dirs.at(i));
+		}
+	}
+}
+
+/*another volume can only be reached via a link or mount point, so only those are checked*/
+bool DirectoryScannerTask::acceptVolume(const QString &linkTarget, const quint32 &currentVolume)
+{
+	if(!(m_filter.sameVolume() || m_filter.hasVolumeRules()))
+	{
+		return true;
+	}
+
+	quint32 volume = 0;
+	quint64 fileIndex = 0;
+	if((!DirectoryWalker::identify(linkTarget, volume, fileIndex)) || (volume == currentVolume))
+	{
+		return true;
+	}
+
+	if(m_filter.sameVolume())
+	{
+		qDebug("Skipped, on a different volume: %s", linkTarget.toUtf8().constData());
+		return false;
+	}
+
+	QString fileSystem, driveType;
+	if(DirectoryWalker::volumeType(linkTarget, fileSystem, driveType) && (!m_filter.acceptVolume(fileSystem, driveType)))
+	{
+		qDebug("Skipped, file system \"%s\" (%s) is excluded: %s", fileSystem.toUtf8().constData(), driveType.toUtf8().constData(), linkTarget.toUtf8().constData());
+		return false;
+	}
 
-	emit directoryAnalyzed(&files, &dirs);
+	return true;
 }
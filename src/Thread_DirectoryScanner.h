@@ -27,30 +27,121 @@
 #include <QStringList>
 #include <QQueue>
 #include <QSet>
+#include <QPair>
+#include <QHash>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QAtomicInt>
+
+#include "FileRecord.h"
+#include "ScanFilter.h"
+#include "DirectoryWalker.h"
+#include "DirectoryCache.h"
 
 class QThreadPool;
-class QEventLoop;
 
 //=======================================================================================
 
-class DirectoryScannerTask : public QObject, public QRunnable
+/*directories that have been visited so far, shared by all scanner tasks*/
+class VisitedDirectories
 {
-	Q_OBJECT
+public:
+	bool insert(const QString &directory, const bool &identified, const quint32 &volume, const quint64 &fileIndex);
+	void clear(void);
+
+protected:
+	bool hasStableIndex(const QString &directory, const quint32 &volume);
+
+	QMutex m_lock;
+	QSet<QPair<quint32, quint64> > m_visited;
+	QSet<QString> m_visitedPaths;
+	QHash<quint32, bool> m_stableVolumes;
+};
+
+//=======================================================================================
+
+/*per-worker queues of pending directories, a worker that runs dry steals from the others*/
+class WorkQueues
+{
+public:
+	WorkQueues(const int &count, const int &order);
+	~WorkQueues(void);
+
+	//A directory that still needs to be listed, or a batch of entries of a large directory that has been listed already
+	typedef struct
+	{
+		QString directory;
+		QList<DirectoryWalker::entry_t> entries;
+		quint32 volume;
+		bool identified;
+		bool isBatch;
+	}
+	item_t;
+
+	void push(const int &owner, const QString &directory);
+	void pushBatch(const int &owner, const QString &directory, const QList<DirectoryWalker::entry_t> &entries, const quint32 &volume, const bool &identified);
+	bool pop(const int &owner, item_t &item, volatile bool *abortFlag);
+	void done(void);
+
+	int peakLength(void) const { return m_peak; }
 
+protected:
+	typedef struct
+	{
+		QMutex lock;
+		QQueue<item_t> items;
+	}
+	queue_t;
+
+	void pushItem(const int &owner, const item_t &item);
+	bool takeFromBack(void) const;
+
+	const int m_count;
+	const int m_order;
+	QList<queue_t*> m_queues;
+	QAtomicInt m_pending;
+	QAtomicInt m_queued;
+	QAtomicInt m_peak;
+
+	QMutex m_idleLock;
+	QWaitCondition m_idleWait;
+};
+
+//=======================================================================================
+
+class DirectoryScanner;
+
+class DirectoryScannerTask : public QRunnable
+{
 public:
-	DirectoryScannerTask(const QString &directory, volatile bool *abortFlag);
+	DirectoryScannerTask(const int &index, WorkQueues *queues, DirectoryScanner *scanner);
 	virtual ~DirectoryScannerTask(void);
 
-signals:
-	void directoryAnalyzed(const QStringList *files, const QStringList *dirs);
+	const QList<fileRecord_t> &getFiles(void) const { return m_files; }
+	const QList<fileRecord_t> &getLinkedFiles(void) const { return m_linkedFiles; }
+	const QHash<QString, QByteArray> &getMemberHashes(void) const { return m_memberHashes; }
 
 protected:
 	virtual void run(void);
-	
-	const QString m_directory;
+	void scanDirectory(const QString &directory);
+	void classifyEntries(const QString &directory, const QList<DirectoryWalker::entry_t> &entries, const quint32 &volume, const bool &identified);
+	bool acceptVolume(const QString &linkTarget, const quint32 &currentVolume);
+
+	const int m_index;
+	const bool m_recursive;
+	const quint32 m_shardIndex;
+	const quint32 m_shardCount;
+	const bool m_archives;
+	const ScanFilter m_filter;
+	DirectoryCache *const m_cache;
+	WorkQueues *const m_queues;
+	DirectoryScanner *const m_scanner;
+	VisitedDirectories *const m_visited;
 	volatile bool *const m_abortFlag;
+
+	QList<fileRecord_t> m_files;
+	QList<fileRecord_t> m_linkedFiles;
+	QHash<QString, QByteArray> m_memberHashes;
 };
 
 //=======================================================================================
@@ -63,31 +154,61 @@ public:
 	DirectoryScanner(volatile bool *abortFlag, const int &threadCount = -1, const bool recursive = true);
 	virtual ~DirectoryScanner(void);
 
+	//Traversal order
+	typedef enum
+	{
+		TRAVERSAL_DEPTH_FIRST   = 0,
+		TRAVERSAL_BREADTH_FIRST = 1,
+		TRAVERSAL_HYBRID        = 2
+	}
+	traversalOrder_t;
+
 	void setRecursive(const bool &recusrive);
+	void setTraversalOrder(const int &order);
+	void setShard(const quint32 &index, const quint32 &count);
+	void setArchiveMode(const bool &enabled);
+	void setFilter(const ScanFilter &filter);
+	void setCacheFile(const QString &cacheFile);
 	void addDirectory(const QString &path);
 	void addDirectories(const QStringList &paths);
+	void addFileLists(const QStringList &listFiles);
 	void suspend(const bool bSuspend);
 
-	const QStringList getFiles(void) const;
+	const QList<fileRecord_t> &getFiles(void) const;
+	const QHash<QString, QByteArray> &getMemberHashes(void) const;
+	const quint64 &getFileCount(void) const;
+
+	static QStringList pruneRoots(const QList<QString> &roots, const bool &recursive);
 
-private slots:
-	void directoryDone(const QStringList *files, const QStringList *dirs);
-	
 protected:
+	friend class DirectoryScannerTask;
+
 	virtual void run(void);
-	void scanDirectory(const QString path);
+	bool readFileList(const QString &listFile);
+	bool acceptListEntry(const QByteArray &line, fileRecord_t &record);
 	void sleepWhilePaused(void);
 
 	bool m_recusrive;
 	bool m_pauseFlag;
+	bool m_archives;
+	int m_traversalOrder;
+	ScanFilter m_filter;
+	QString m_cacheFile;
+	DirectoryCache m_cache;
+
+	quint32 m_shardIndex;
+	quint32 m_shardCount;
 
 	QThreadPool*   m_pool;
 	QMutex         m_pauseLock;
 	QWaitCondition m_pauseWait;
 
 	QQueue<QString> m_pendingDirs;
-	QSet<QString>   m_files;
-	quint64         m_pendingTasks;
+	QStringList     m_fileLists;
+	QList<fileRecord_t> m_files;
+	QHash<QString, QByteArray> m_memberHashes;
+	quint64             m_fileCount;
+	VisitedDirectories  m_visited;
 
 	volatile bool *const m_abortFlag;
 };
@@ -0,0 +1,779 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Thread_DirectoryWatcher.h"
+
+#include "Config.h"
+#include "DirectoryWalker.h"
+#include "ArchiveReader.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QMetaType>
+
+static const DWORD  NOTIFY_BUFFER_SIZE = 65536; /*larger buffers are not supported for network shares*/
+static const DWORD  NOTIFY_FILTER      = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+static const DWORD  POLL_INTERVAL      = 250;
+static const qint64 SETTLE_TIME        = 1000;  /*changes are processed once the directories have been quiet for this long...*/
+static const qint64 MAX_DELAY          = 5000;  /*...but they are never held back for longer than this*/
+static const int    MAX_PENDING_PATHS  = 16384;
+static const int    MAX_WATCHED_FILES  = 4194304; /*each watched file takes roughly 200 Bytes*/
+static const qint64 READ_BUFFER_SIZE   = 1048576;
+
+static inline QString ROOT_PREFIX(const QString &root)
+{
+	return root.endsWith('/') ? root : (root + '/');
+}
+
+static inline QString PARENT_PATH(const QString &path)
+{
+	const int pos = path.lastIndexOf('/');
+	return (pos > 0) ? path.left(pos) : QString();
+}
+
+static inline void ADD_PARENT_DIRS(QSet<QString> &knownDirs, const QString &path)
+{
+	for(QString dir = PARENT_PATH(path); (!dir.isEmpty()) && (!knownDirs.contains(dir)); dir = PARENT_PATH(dir))
+	{
+		knownDirs.insert(dir);
+	}
+}
+
+template<typename K>
+static inline void REMOVE_PATH(QHash<K, QSet<QString> > &index, const K &key, const QString &path)
+{
+	typename QHash<K, QSet<QString> >::Iterator iter = index.find(key);
+	if(iter != index.end())
+	{
+		iter->remove(path);
+		if(iter->isEmpty())
+		{
+			index.erase(iter);
+		}
+	}
+}
+
+static bool HASH_FILE(const QString &path, QByteArray &digest, volatile bool *const stopFlag)
+{
+	QFile file(path);
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Failed to open: %s", path.toUtf8().constData());
+		return false;
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	while(!(file.atEnd() || (file.error() != QFile::NoError) || (*stopFlag)))
+	{
+		hash.addData(file.read(READ_BUFFER_SIZE));
+	}
+
+	const bool okay = (file.error() == QFile::NoError) && (!(*stopFlag));
+	file.close();
+
+	if(okay)
+	{
+		digest = hash.result();
+	}
+
+	return okay;
+}
+
+//=======================================================================================
+// Watched Root
+//=======================================================================================
+
+/*a watched directory with its outstanding ReadDirectoryChangesW request*/
+class WatchedRoot
+{
+public:
+	WatchedRoot(const QString &directory, const bool &watchSubtree)
+	:
+		path(directory),
+		recursive(watchSubtree),
+		pending(false)
+	{
+		const QString nativePath = QDir::toNativeSeparators(directory);
+		memset(&overlapped, 0, sizeof(OVERLAPPED));
+		handle = CreateFileW((const wchar_t*)nativePath.utf16(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+		overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+	}
+
+	~WatchedRoot(void)
+	{
+		if(pending)
+		{
+			DWORD bytes = 0;
+			CancelIo(handle);
+			GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+		}
+		if(handle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(handle);
+		}
+		if(overlapped.hEvent)
+		{
+			CloseHandle(overlapped.hEvent);
+		}
+	}
+
+	inline bool isOpen(void) const
+	{
+		return (handle != INVALID_HANDLE_VALUE) && (overlapped.hEvent != NULL);
+	}
+
+	bool arm(void)
+	{
+		pending = (ReadDirectoryChangesW(handle, buffer, NOTIFY_BUFFER_SIZE, recursive ? TRUE : FALSE, NOTIFY_FILTER, NULL, &overlapped, NULL) != FALSE);
+		return pending;
+	}
+
+	bool complete(DWORD &bytes)
+	{
+		pending = false;
+		return (GetOverlappedResult(handle, &overlapped, &bytes, FALSE) != FALSE);
+	}
+
+	const QString path;
+	const bool recursive;
+	HANDLE handle;
+	OVERLAPPED overlapped;
+	bool pending;
+	DWORD buffer[NOTIFY_BUFFER_SIZE / sizeof(DWORD)];
+};
+
+//=======================================================================================
+// Directory Watcher
+//=======================================================================================
+
+DirectoryWatcher::DirectoryWatcher(void)
+:
+	m_recusrive(true),
+	m_entriesFull(false),
+	m_stopFlag(false)
+{
+	qRegisterMetaType<ResultStore::change_t>("ResultStore::change_t");
+}
+
+DirectoryWatcher::~DirectoryWatcher(void)
+{
+	stop();
+	wait();
+}
+
+void DirectoryWatcher::run(void)
+{
+	qDebug("[Watching Directories]");
+
+	m_pendingPaths.clear();
+	m_pendingRoots.clear();
+
+	if(!openRoots())
+	{
+		qWarning("None of the directories can be watched!");
+		closeRoots();
+		return;
+	}
+
+	QElapsedTimer firstChange, lastChange;
+	firstChange.invalidate();
+
+	while((!m_stopFlag) && (!m_roots.isEmpty()))
+	{
+		HANDLE events[MAXIMUM_WAIT_OBJECTS];
+		const int rootCount = m_roots.count();
+		for(int i = 0; i < rootCount; i++)
+		{
+			events[i] = m_roots.at(i)->overlapped.hEvent;
+		}
+
+		const DWORD result = WaitForMultipleObjects(rootCount, events, FALSE, POLL_INTERVAL);
+		if((result >= WAIT_OBJECT_0) && (result < (WAIT_OBJECT_0 + rootCount)))
+		{
+			WatchedRoot *root = m_roots.at(result - WAIT_OBJECT_0);
+			if(!collectChanges(root))
+			{
+				qWarning("Stopped watching: %s", root->path.toUtf8().constData());
+				m_roots.removeAll(root);
+				MY_DELETE(root);
+			}
+			if(!firstChange.isValid())
+			{
+				firstChange.start();
+			}
+			lastChange.start();
+		}
+		else if(result == WAIT_FAILED)
+		{
+			qWarning("Failed to wait for directory changes!");
+			break;
+		}
+
+		if(firstChange.isValid() && ((lastChange.elapsed() >= SETTLE_TIME) || (firstChange.elapsed() >= MAX_DELAY)))
+		{
+			processChanges();
+			firstChange.invalidate();
+		}
+	}
+
+	closeRoots();
+	qDebug("Stopped watching directories.");
+}
+
+bool DirectoryWatcher::openRoots(void)
+{
+	closeRoots();
+
+	for(QStringList::ConstIterator iter = m_directories.constBegin(); iter != m_directories.constEnd(); iter++)
+	{
+		if(m_roots.count() >= MAXIMUM_WAIT_OBJECTS)
+		{
+			qWarning("Too many directories, not watching: %s", iter->toUtf8().constData());
+			continue;
+		}
+		WatchedRoot *root = new WatchedRoot(*iter, m_recusrive);
+		if(root->isOpen() && root->arm())
+		{
+			m_roots << root;
+			continue;
+		}
+		qWarning("Failed to watch directory: %s", iter->toUtf8().constData());
+		MY_DELETE(root);
+	}
+
+	return (!m_roots.isEmpty());
+}
+
+void DirectoryWatcher::closeRoots(void)
+{
+	while(!m_roots.isEmpty())
+	{
+		WatchedRoot *root = m_roots.takeFirst();
+		MY_DELETE(root);
+	}
+}
+
+/*changes are only collected here, nothing is read from the disk until the directories settle down*/
+bool DirectoryWatcher::collectChanges(WatchedRoot *const root)
+{
+	DWORD bytes = 0;
+	if(root->complete(bytes) && (bytes > 0))
+	{
+		const BYTE *position = reinterpret_cast<const BYTE*>(root->buffer);
+		const QString prefix = ROOT_PREFIX(root->path);
+		forever
+		{
+			const FILE_NOTIFY_INFORMATION *const info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(position);
+			const QString path = prefix + QString::fromUtf16((const ushort*)info->FileName, info->FileNameLength / sizeof(WCHAR)).replace('\\', '/');
+			const bool created = (info->Action == FILE_ACTION_ADDED) || (info->Action == FILE_ACTION_RENAMED_NEW_NAME);
+			m_pendingPaths.insert(path, m_pendingPaths.value(path, false) || created);
+			if(info->NextEntryOffset == 0)
+			{
+				break;
+			}
+			position += info->NextEntryOffset;
+		}
+	}
+	else
+	{
+		/*the notification buffer has overflowed, so the whole tree needs to be compared again*/
+		qWarning("Too many changes at once, rescanning: %s", root->path.toUtf8().constData());
+		m_pendingRoots.insert(root->path);
+	}
+
+	/*during an event storm the paths are no longer tracked one by one, the affected trees are compared once it is over*/
+	if(m_pendingPaths.count() > MAX_PENDING_PATHS)
+	{
+		for(QHash<QString, bool>::ConstIterator iter = m_pendingPaths.constBegin(); iter != m_pendingPaths.constEnd(); iter++)
+		{
+			for(QStringList::ConstIterator dir = m_directories.constBegin(); dir != m_directories.constEnd(); dir++)
+			{
+				if(iter.key().startsWith(ROOT_PREFIX(*dir), Qt::CaseInsensitive))
+				{
+					m_pendingRoots.insert(*dir);
+				}
+			}
+		}
+		m_pendingPaths.clear();
+	}
+
+	return root->arm();
+}
+
+void DirectoryWatcher::processChanges(void)
+{
+	qDebug("Processing %d changed path(s) and %d rescanned directories.", m_pendingPaths.count(), m_pendingRoots.count());
+
+	for(QSet<QString>::ConstIterator iter = m_pendingRoots.constBegin(); iter != m_pendingRoots.constEnd(); iter++)
+	{
+		updateTree(*iter, true);
+	}
+
+	for(QHash<QString, bool>::ConstIterator iter = m_pendingPaths.constBegin(); (iter != m_pendingPaths.constEnd()) && (!m_stopFlag); iter++)
+	{
+		bool covered = false;
+		for(QSet<QString>::ConstIterator root = m_pendingRoots.constBegin(); (root != m_pendingRoots.constEnd()) && (!covered); root++)
+		{
+			covered = iter.key().startsWith(ROOT_PREFIX(*root), Qt::CaseInsensitive);
+		}
+		if(!covered)
+		{
+			updatePath(iter.key(), iter.value());
+		}
+	}
+
+	m_pendingPaths.clear();
+	m_pendingRoots.clear();
+
+	for(QSet<qint64>::ConstIterator iter = m_affectedSizes.constBegin(); (iter != m_affectedSizes.constEnd()) && (!m_stopFlag); iter++)
+	{
+		regroup(*iter);
+	}
+
+	m_affectedSizes.clear();
+	reportChanges();
+}
+
+/*the directories between the watched root and the path must pass the filter as well*/
+bool DirectoryWatcher::acceptPath(const QString &path) const
+{
+	for(QStringList::ConstIterator iter = m_directories.constBegin(); iter != m_directories.constEnd(); iter++)
+	{
+		const QString prefix = ROOT_PREFIX(*iter);
+		if(path.startsWith(prefix, Qt::CaseInsensitive))
+		{
+			const QStringList names = path.mid(prefix.length()).split('/', QString::SkipEmptyParts);
+			if((!m_recusrive) && (names.count() > 1))
+			{
+				return false;
+			}
+			QString current = prefix;
+			for(int i = 0; i < names.count() - 1; i++)
+			{
+				current += names.at(i);
+				if(!m_filter.acceptDirectory(names.at(i), current))
+				{
+					return false;
+				}
+				current += '/';
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void DirectoryWatcher::updatePath(const QString &path, const bool &created)
+{
+	QString archivePath, memberName;
+	if(ArchiveReader::splitPath(path, archivePath, memberName) || (!acceptPath(path)))
+	{
+		return;
+	}
+
+	const QFileInfo info(path);
+	if(!info.exists())
+	{
+		removeFile(path);
+		if(m_knownDirs.contains(path))
+		{
+			removeTree(path);
+		}
+		return;
+	}
+
+	if(info.isDir())
+	{
+		/*a directory reports a modification for every change inside, which is handled on its own already*/
+		if(created && m_recusrive && m_filter.acceptDirectory(info.fileName(), path))
+		{
+			updateTree(path, false);
+		}
+		return;
+	}
+
+	const QString name = info.fileName();
+	const qint64 size = info.size(), mtime = info.lastModified().toMSecsSinceEpoch();
+
+	if(m_filter.isMarker(name, path))
+	{
+		removeTree(PARENT_PATH(path));
+		return;
+	}
+
+	if(info.isFile() && m_filter.acceptFile(name, path, size, mtime))
+	{
+		updateFile(path, size, mtime);
+	}
+	else
+	{
+		removeFile(path);
+	}
+}
+
+/*links are not followed here, they are only picked up by a full scan*/
+void DirectoryWatcher::updateTree(const QString &directory, const bool &removeMissing)
+{
+	QStringList pendingDirs(directory);
+	QSet<QString> foundFiles;
+
+	while((!pendingDirs.isEmpty()) && (!m_stopFlag))
+	{
+		const QString current = pendingDirs.takeLast();
+		const QString prefix = ROOT_PREFIX(current);
+		QList<fileRecord_t> files;
+		QStringList dirs;
+		bool skipped = false;
+
+		DirectoryWalker walker(current);
+		DirectoryWalker::entry_t entry;
+		while(walker.next(entry) && (!m_stopFlag))
+		{
+			const QString path = prefix + entry.name;
+			if(DirectoryWalker::isLink(entry))
+			{
+				continue;
+			}
+			if(DirectoryWalker::isDirectory(entry))
+			{
+				if(m_recusrive && m_filter.acceptDirectory(entry.name, path))
+				{
+					dirs << path;
+				}
+				continue;
+			}
+			if(m_filter.isMarker(entry.name, path))
+			{
+				skipped = true;
+				break;
+			}
+			if(m_filter.acceptFile(entry.name, path, entry.size, entry.mtime))
+			{
+				files << MAKE_FILE_RECORD(path, entry.size, entry.mtime);
+			}
+		}
+
+		if(skipped)
+		{
+			continue;
+		}
+
+		for(QList<fileRecord_t>::ConstIterator iter = files.constBegin(); iter != files.constEnd(); iter++)
+		{
+			updateFile(iter->path, iter->size, iter->mtime);
+			foundFiles.insert(iter->path);
+		}
+		pendingDirs << dirs;
+	}
+
+	if(removeMissing && (!m_stopFlag))
+	{
+		const QString prefix = ROOT_PREFIX(directory);
+		QStringList missingFiles;
+		for(QHash<QString, entry_t>::ConstIterator iter = m_entries.constBegin(); iter != m_entries.constEnd(); iter++)
+		{
+			if(iter.key().startsWith(prefix, Qt::CaseInsensitive) && (!foundFiles.contains(iter.key())))
+			{
+				missingFiles << iter.key();
+			}
+		}
+		for(QStringList::ConstIterator iter = missingFiles.constBegin(); iter != missingFiles.constEnd(); iter++)
+		{
+			removeFile(*iter);
+		}
+	}
+}
+
+void DirectoryWatcher::updateFile(const QString &path, const qint64 &size, const qint64 &mtime)
+{
+	QHash<QString, entry_t>::Iterator iter = m_entries.find(path);
+	if(iter != m_entries.end())
+	{
+		if((iter->size == size) && (iter->mtime == mtime))
+		{
+			return;
+		}
+		m_affectedSizes.insert(iter->size);
+		setHash(path, QByteArray());
+		REMOVE_PATH(m_bySize, iter->size, path);
+		iter->size = size;
+		iter->mtime = mtime;
+	}
+	else
+	{
+		/*files keep being created while the program runs, so the index must not grow without limit*/
+		if(m_entries.count() >= MAX_WATCHED_FILES)
+		{
+			if(!m_entriesFull)
+			{
+				qWarning("Watching %d files already, new files are ignored!", m_entries.count());
+				m_entriesFull = true;
+			}
+			return;
+		}
+		entry_t entry;
+		entry.size = size;
+		entry.mtime = mtime;
+		m_entries.insert(path, entry);
+		ADD_PARENT_DIRS(m_knownDirs, path);
+	}
+
+	m_bySize[size].insert(path);
+	m_affectedSizes.insert(size);
+}
+
+void DirectoryWatcher::removeFile(const QString &path)
+{
+	QHash<QString, entry_t>::Iterator iter = m_entries.find(path);
+	if(iter != m_entries.end())
+	{
+		m_affectedSizes.insert(iter->size);
+		setHash(path, QByteArray());
+		REMOVE_PATH(m_bySize, iter->size, path);
+		m_entries.erase(iter);
+	}
+}
+
+void DirectoryWatcher::removeTree(const QString &directory)
+{
+	const QString prefix = ROOT_PREFIX(directory);
+
+	QStringList removedFiles;
+	for(QHash<QString, entry_t>::ConstIterator iter = m_entries.constBegin(); iter != m_entries.constEnd(); iter++)
+	{
+		if(iter.key().startsWith(prefix, Qt::CaseInsensitive))
+		{
+			removedFiles << iter.key();
+		}
+	}
+	for(QStringList::ConstIterator iter = removedFiles.constBegin(); iter != removedFiles.constEnd(); iter++)
+	{
+		removeFile(*iter);
+	}
+
+	for(QSet<QString>::Iterator iter = m_knownDirs.begin(); iter != m_knownDirs.end();)
+	{
+		if(iter->startsWith(prefix, Qt::CaseInsensitive))
+		{
+			iter = m_knownDirs.erase(iter);
+			continue;
+		}
+		iter++;
+	}
+	m_knownDirs.remove(directory);
+}
+
+/*the digest of a file is assigned, replaced or cleared, the old and the new group are both affected*/
+void DirectoryWatcher::setHash(const QString &path, const QByteArray &hash)
+{
+	QHash<QString, entry_t>::Iterator iter = m_entries.find(path);
+	if(iter == m_entries.end())
+	{
+		return;
+	}
+
+	if(!iter->hash.isEmpty())
+	{
+		m_affectedHashes.insert(iter->hash);
+		REMOVE_PATH(m_byHash, iter->hash, path);
+	}
+
+	iter->hash = hash;
+
+	if(!hash.isEmpty())
+	{
+		m_affectedHashes.insert(hash);
+		m_byHash[hash].insert(path);
+	}
+}
+
+/*digests are only computed for files that share their size with at least one other file*/
+void DirectoryWatcher::regroup(const qint64 &size)
+{
+	const QSet<QString> paths = m_bySize.value(size);
+	if(paths.count() < 2)
+	{
+		return;
+	}
+
+	for(QSet<QString>::ConstIterator iter = paths.constBegin(); (iter != paths.constEnd()) && (!m_stopFlag); iter++)
+	{
+		if(m_entries.value(*iter).hash.isEmpty())
+		{
+			QByteArray hash;
+			if(HASH_FILE(*iter, hash, &m_stopFlag))
+			{
+				setHash(*iter, hash);
+			}
+		}
+	}
+}
+
+void DirectoryWatcher::reportChanges(void)
+{
+	for(QSet<QByteArray>::ConstIterator iter = m_affectedHashes.constBegin(); iter != m_affectedHashes.constEnd(); iter++)
+	{
+		QStringList files = m_byHash.value(*iter).toList();
+		files.sort();
+
+		QHash<QByteArray, ResultStore::group_t>::Iterator previous = m_groups.find(*iter);
+		ResultStore::change_t change;
+
+		if(files.count() < 2)
+		{
+			if(previous == m_groups.end())
+			{
+				continue;
+			}
+			change.changeType = ResultStore::CHANGE_RESOLVED;
+			change.group = previous.value();
+			change.removed = previous->files;
+			m_groups.erase(previous);
+		}
+		else
+		{
+			ResultStore::group_t current;
+			current.hash = (*iter);
+			current.size = m_entries.value(files.first()).size;
+			current.files = files;
+			if(previous == m_groups.end())
+			{
+				change.changeType = ResultStore::CHANGE_NEW;
+				change.group = current;
+				change.added = files;
+				m_groups.insert(current.hash, current);
+			}
+			else
+			{
+				ResultStore::diffGroup(previous.value(), current, change);
+				if(change.changeType == ResultStore::CHANGE_NONE)
+				{
+					continue;
+				}
+				previous.value() = current;
+			}
+		}
+
+		qDebug("[%s] %s: %d file(s), %d added, %d removed", ResultStore::changeName(change.changeType).toUtf8().constData(), iter->toHex().constData(), change.group.files.count(), change.added.count(), change.removed.count());
+		emit groupChanged(change);
+	}
+
+	m_affectedHashes.clear();
+}
+
+void DirectoryWatcher::setRecursive(const bool &recusrive)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_recusrive = recusrive;
+}
+
+void DirectoryWatcher::setFilter(const ScanFilter &filter)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_filter = filter;
+}
+
+void DirectoryWatcher::setDirectories(const QStringList &paths)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_directories.clear();
+	for(QStringList::ConstIterator iter = paths.constBegin(); iter != paths.constEnd(); iter++)
+	{
+		const QString canonicalPath = QFileInfo(*iter).canonicalFilePath();
+		m_directories << (canonicalPath.isEmpty() ? (*iter) : canonicalPath);
+	}
+}
+
+/*builds the index from the result of the initial scan, only the files in duplicate groups have a known digest*/
+void DirectoryWatcher::seed(const QList<fileRecord_t> &files, const QList<ResultStore::group_t> &groups)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_stopFlag = false;
+	m_entriesFull = false;
+	m_entries.clear();
+	m_bySize.clear();
+	m_byHash.clear();
+	m_groups.clear();
+	m_knownDirs.clear();
+
+	for(QList<fileRecord_t>::ConstIterator iter = files.constBegin(); iter != files.constEnd(); iter++)
+	{
+		QString archivePath, memberName;
+		if(!ArchiveReader::splitPath(iter->path, archivePath, memberName))
+		{
+			updateFile(iter->path, iter->size, iter->mtime);
+		}
+	}
+
+	for(QList<ResultStore::group_t>::ConstIterator iter = groups.constBegin(); iter != groups.constEnd(); iter++)
+	{
+		for(QStringList::ConstIterator file = iter->files.constBegin(); file != iter->files.constEnd(); file++)
+		{
+			setHash(*file, iter->hash);
+		}
+		ResultStore::group_t group = (*iter);
+		group.files = m_byHash.value(iter->hash).toList();
+		group.files.sort();
+		if(group.files.count() > 1)
+		{
+			m_groups.insert(group.hash, group);
+		}
+	}
+
+	m_affectedSizes.clear();
+	m_affectedHashes.clear();
+
+	qDebug("Watching %d files in %d duplicate group(s).", m_entries.count(), m_groups.count());
+}
+
+void DirectoryWatcher::stop(void)
+{
+	m_stopFlag = true;
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QThread>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+#include "FileRecord.h"
+#include "ScanFilter.h"
+#include "ResultStore.h"
+
+class WatchedRoot;
+
+//=======================================================================================
+
+/*
+ * Keeps watching the scanned directories once the initial scan is complete. The index
+ * maps every file to its size and, if it shares its size with another file, to its
+ * SHA-1 digest. Change notifications are collected until the directories settle down,
+ * then only the affected sizes are re-examined and the changed groups are reported.
+ */
+
+class DirectoryWatcher : public QThread
+{
+	Q_OBJECT
+
+public:
+	DirectoryWatcher(void);
+	virtual ~DirectoryWatcher(void);
+
+	void setRecursive(const bool &recusrive);
+	void setFilter(const ScanFilter &filter);
+	void setDirectories(const QStringList &paths);
+	void seed(const QList<fileRecord_t> &files, const QList<ResultStore::group_t> &groups);
+	void stop(void);
+
+signals:
+	void groupChanged(const ResultStore::change_t &change);
+
+protected:
+	typedef struct
+	{
+		qint64 size;
+		qint64 mtime;
+		QByteArray hash;
+	}
+	entry_t;
+
+	virtual void run(void);
+	bool openRoots(void);
+	void closeRoots(void);
+	bool collectChanges(WatchedRoot *const root);
+	void processChanges(void);
+
+	bool acceptPath(const QString &path) const;
+	void updatePath(const QString &path, const bool &created);
+	void updateTree(const QString &directory, const bool &removeMissing);
+	void updateFile(const QString &path, const qint64 &size, const qint64 &mtime);
+	void removeFile(const QString &path);
+	void removeTree(const QString &directory);
+	void setHash(const QString &path, const QByteArray &hash);
+	void regroup(const qint64 &size);
+	void reportChanges(void);
+
+	bool m_recusrive;
+	ScanFilter m_filter;
+	QStringList m_directories;
+	QList<WatchedRoot*> m_roots;
+
+	QHash<QString, entry_t> m_entries;
+	bool m_entriesFull;
+	QHash<qint64, QSet<QString> > m_bySize;
+	QHash<QByteArray, QSet<QString> > m_byHash;
+	QHash<QByteArray, ResultStore::group_t> m_groups;
+	QSet<QString> m_knownDirs;
+
+	QHash<QString, bool> m_pendingPaths;
+	QSet<QString> m_pendingRoots;
+	QSet<qint64> m_affectedSizes;
+	QSet<QByteArray> m_affectedHashes;
+
+	volatile bool m_stopFlag;
+};
@@ -23,42 +23,160 @@
 #include "Thread_FileComparator.h"
 
 #include "Model_Duplicates.h"
+#include "PartialResult.h"
+#include "Chunker.h"
+#include "MinHash.h"
+#include "DirectoryTree.h"
+#include "ArchiveReader.h"
 #include "Config.h"
 #include "System.h"
-
-#include "strnatcmp/strnatcmp.h"
+#include "Utilities.h"
 
 #include <QThreadPool>
 #include <QDir>
 #include <QDirIterator>
 #include <QEventLoop>
 #include <QTimer>
+#include <QMap>
+#include <QSet>
 #include <QCryptographicHash>
+#include <QMetaType>
 
 #include <cassert>
 
 static const quint64 MAX_ENQUEUED_TASKS = 128;
+
+/*files are read in large blocks, small files only get a buffer as big as the file*/
+static const qint64 MIN_READ_SIZE = 4096;
+static const qint64 MAX_READ_SIZE = 1048576;
+
+/*duplicate groups are handed to the model in batches*/
+static const int    DUPLICATE_BATCH_SIZE = 256;
+static const qint64 STREAM_INTERVAL = 250;
+
+/*partial overlap detection*/
+static const qint64 OVERLAP_MIN_FILESIZE = 1048576;
+static const qint64 OVERLAP_MIN_SHARED   = 1048576;
+static const int    OVERLAP_MAX_POSTINGS = 32;
+
+/*similarity detection, LSH banding with 32 bands of 4 rows each*/
+static const qint64 SIMILAR_MIN_FILESIZE = 1024;
+static const qint64 SIMILAR_MAX_FILESIZE = 67108864;
+static const int    SIMILAR_MIN_PERCENT  = 50;
+static const int    SIMILAR_MAX_BUCKET   = 64;
+static const int    LSH_BANDS = 32;
+static const int    LSH_ROWS  = MinHash::NUM_BINS / LSH_BANDS;
+
+static inline quint32 UNION_FIND(QVector<quint32> &parent, quint32 x)
+{
+	while(parent[x] != x)
+	{
+		x = parent[x] = parent[parent[x]];
+	}
+	return x;
+}
 static const QHash<QByteArray, QStringList> EMPTY_DUPLICATES_LIST;
 
-static bool filePathLessThan(const QString &s1, const QString &s2)
+static inline bool FILE_SIZE_GREATER(const fileRecord_t &r1, const fileRecord_t &r2)
 {
-	int result = 0;
+	return r1.size > r2.size;
+}
 
-	const wchar_t *file1 = wcsrchr((const wchar_t*) s1.utf16(), L'/');
-	const wchar_t *file2 = wcsrchr((const wchar_t*) s2.utf16(), L'/');
+//=======================================================================================
+// Archive Member Hasher
+//=======================================================================================
 
-	if(file1 && file2)
+/*hashes the requested members of an archive, as they are streamed by the ArchiveReader*/
+class MemberHasher : public ArchiveReader::Handler
+{
+public:
+	typedef struct
 	{
-		result = strnatcasecmp(++file1, ++file2);
+		QString name;
+		QByteArray hash;
+		qint64 size;
+		bool chunked;
+		bool sketched;
+		Chunker chunker;
+		MinHash minHash;
 	}
+	member_t;
 
-	if(result == 0)
+	MemberHasher(const QStringList &members, volatile bool *abortFlag, const bool &chunking, const bool &sketching)
+	:
+		m_abortFlag(abortFlag), m_chunking(chunking), m_sketching(sketching), m_hash(QCryptographicHash::Sha1)
 	{
-		result = strnatcasecmp((const wchar_t*) s1.utf16(), (const wchar_t*) s2.utf16());
+		/*an archive may contain the same name more than once, each of them is a separate member*/
+		for(QStringList::ConstIterator iter = members.constBegin(); iter != members.constEnd(); iter++)
+		{
+			m_pending[*iter]++;
+		}
 	}
 
-	return (result < 0);
-}
+	virtual bool wantMember(const QString &name, const qint64 &size)
+	{
+		if(!m_pending.contains(name))
+		{
+			return false;
+		}
+		m_current.name = name;
+		m_current.size = 0;
+		m_current.chunked = m_chunking && (size >= OVERLAP_MIN_FILESIZE);
+		m_current.sketched = m_sketching && (size >= SIMILAR_MIN_FILESIZE) && (size <= SIMILAR_MAX_FILESIZE);
+		m_current.chunker.reset();
+		m_current.minHash.reset();
+		m_hash.reset();
+		return true;
+	}
+
+	virtual bool memberData(const char *data, const qint64 &len)
+	{
+		if(*m_abortFlag)
+		{
+			return false;
+		}
+		m_hash.addData(data, int(len));
+		m_current.size += len;
+		if(m_current.chunked)
+		{
+			m_current.chunker.update(data, len);
+		}
+		if(m_current.sketched)
+		{
+			m_current.minHash.update(data, len);
+		}
+		return true;
+	}
+
+	virtual void memberDone(void)
+	{
+		if(m_current.chunked)
+		{
+			m_current.chunker.finish();
+		}
+		m_current.sketched = m_current.sketched && m_current.minHash.finish();
+		m_current.hash = m_hash.result();
+		m_results << m_current;
+		QHash<QString, int>::Iterator pending = m_pending.find(m_current.name);
+		if((pending != m_pending.end()) && (--pending.value() < 1))
+		{
+			m_pending.erase(pending);
+		}
+	}
+
+	inline const QList<member_t> &results(void) const { return m_results; }
+	inline const QHash<QString, int> &pending(void) const { return m_pending; }
+
+protected:
+	QHash<QString, int> m_pending;
+	volatile bool *const m_abortFlag;
+	const bool m_chunking;
+	const bool m_sketching;
+
+	QCryptographicHash m_hash;
+	member_t m_current;
+	QList<member_t> m_results;
+};
 
 //=======================================================================================
 // File Comparator
@@ -73,6 +191,15 @@ FileComparator::FileComparator(volatile bool *abortFlag, const int &threadCount)
 	m_pendingTasks = 0;
 	m_pool = new QThreadPool();
 	m_pauseFlag = false;
+	m_overlapDetection = false;
+	m_similarityDetection = false;
+	m_directoryMode = DIRECTORIES_OFF;
+	m_streaming = false;
+	m_streamResults = false;
+
+	qRegisterMetaType<QList<qint64> >("QList<qint64>");
+	qRegisterMetaType<QList<fileRecord_t> >("QList<fileRecord_t>");
+	qRegisterMetaType<QList<duplicateGroup_t> >("QList<duplicateGroup_t>");
 
 	m_completedFileCount = 0;
 	m_totalFileCount = m_files.count();
@@ -97,27 +224,71 @@ void FileComparator::run(void)
 
 	m_hashes.clear();
 	m_fileSizes.clear();
+	m_failedFiles.clear();
+	m_chunkIndex.clear();
+	m_chunkedFiles.clear();
+	m_chunkedSizes.clear();
+	m_chunkedHashes.clear();
+	m_sketchedHashes.clear();
+	m_sketchedFiles.clear();
+	m_sketchedSizes.clear();
+	m_sketches.clear();
+	m_duplicateBatch.clear();
+	m_pendingSizes.clear();
+	m_sizeHashes.clear();
+	m_streamedHashes.clear();
 
 	m_pendingTasks = 0;
 
+	if(!(m_overlapDetection || m_similarityDetection || (m_directoryMode != DIRECTORIES_OFF) || (!m_partialOutput.isEmpty())))
+	{
+		removeUniqueSizes();
+	}
+
+	m_streamResults = m_streaming && (m_directoryMode == DIRECTORIES_OFF);
+	usePrecomputedHashes();
+
+	/*
+	 * When streaming, the largest files are read first. Once every queued file of a size is done,
+	 * the groups of that size are final and can be shown while the smaller files are still read.
+	 */
+	if(m_streamResults)
+	{
+		for(QQueue<fileRecord_t>::ConstIterator iter = m_files.constBegin(); iter != m_files.constEnd(); iter++)
+		{
+			m_pendingSizes[iter->size]++;
+		}
+		qStableSort(m_files.begin(), m_files.end(), FILE_SIZE_GREATER);
+		m_batchTimer.start();
+	}
+	else if(m_streaming)
+	{
+		qWarning("Results can not be streamed while duplicate directories are detected!");
+	}
+
+	groupArchiveMembers();
+
 	m_completedFileCount = 0;
 	m_totalFileCount = m_files.count();
 	m_progressValue = -1;
 	
-	if(m_files.count() < 1)
+	if((m_files.count() < 1) && m_hashes.isEmpty())
 	{
 		qWarning("File list is empty -> Nothing to do!");
 		emit progressChanged(100);
 		return;
 	}
 
-	while((!m_files.empty()) && (m_pendingTasks < MAX_ENQUEUED_TASKS))
+	/*all files may have been hashed in advance, then there is nothing left to read*/
+	if(!m_files.empty())
 	{
-		scanNextFile(m_files.dequeue());
+		while((!m_files.empty()) && (m_pendingTasks < MAX_ENQUEUED_TASKS))
+		{
+			scanNextFile(m_files.dequeue());
+		}
+		exec();
 	}
 
-	exec();
-
 	if(!m_files.empty())
 	{
 		qWarning("Thread is about to exit while there still are pending directories!");
@@ -130,8 +301,18 @@ void FileComparator::run(void)
 		//QEventLoop loop; loop.processEvents();
 	}
 
+	if((!(*m_abortFlag)) && (!m_partialOutput.isEmpty()))
+	{
+		if(!writePartialOutput())
+		{
+			qWarning("Failed to write partial result!");
+		}
+	}
+
 	if(!(*m_abortFlag))
 	{
+		DirectoryTree *directoryTree = (m_directoryMode != DIRECTORIES_OFF) ? searchDirectories() : NULL;
+
 		qDebug("\n[Searching Duplicates]");
 
 		quint32 duplicateCount = 0;
@@ -140,52 +321,219 @@ void FileComparator::run(void)
 
 		for(QList<QByteArray>::ConstIterator iter = keys.constBegin(); iter != keys.constEnd(); iter++)
 		{
-			const int count = m_hashes.count(*iter);
+			const int count = m_streamedHashes.contains(*iter) ? 0 : m_hashes.count(*iter);
 			if(count > 1)
 			{
 				qDebug("%s -> %d", iter->toHex().constData(), count);
-				QList<QString> values = m_hashes.values(*iter);
-				qSort(values.begin(), values.end(), filePathLessThan);
-				emit duplicateFound((*iter), values, m_fileSizes.value((*iter), 0));
+				QList<fileRecord_t> values = m_hashes.values(*iter);
+				qSort(values.begin(), values.end(), FILE_RECORD_LESS_THAN);
+				if(directoryTree)
+				{
+					/*keep only one file per position inside a duplicate directory*/
+					QSet<QString> coveredKeys;
+					for(QList<fileRecord_t>::Iterator value = values.begin(); value != values.end();)
+					{
+						const QString key = directoryTree->coveringKey(value->path, *iter);
+						if((!key.isEmpty()) && coveredKeys.contains(key))
+						{
+							value = values.erase(value);
+							continue;
+						}
+						coveredKeys.insert(key);
+						value++;
+					}
+					if(values.count() < 2)
+					{
+						continue;
+					}
+				}
+				queueDuplicate((*iter), values);
 				duplicateCount++;
 			}
 		}
-	
+
+		flushDuplicates();
+		duplicateCount += m_streamedHashes.count();
 		qDebug("Found %d files with duplicates!", duplicateCount);
+		MY_DELETE(directoryTree);
+
+		if(m_overlapDetection)
+		{
+			searchOverlaps();
+		}
+
+		if(m_similarityDetection)
+		{
+			searchSimilar();
+		}
+
 		emit progressChanged(100);
 	}
 
 	m_hashes.clear();
 	m_fileSizes.clear();
+	m_failedFiles.clear();
+	m_chunkIndex.clear();
+	m_chunkedFiles.clear();
+	m_chunkedSizes.clear();
+	m_chunkedHashes.clear();
+	m_sketchedHashes.clear();
+	m_sketchedFiles.clear();
+	m_sketchedSizes.clear();
+	m_sketches.clear();
+	m_duplicateBatch.clear();
+	m_pendingSizes.clear();
+	m_sizeHashes.clear();
+	m_streamedHashes.clear();
+	m_memberHashes.clear();
 
 	qDebug("Thread will exit!\n");
 }
 
-void FileComparator::scanNextFile(const QString path)
+void FileComparator::scanNextFile(const fileRecord_t record)
 {
 	sleepWhilePaused();
 
-	FileComparatorTask *task = new FileComparatorTask(path, m_abortFlag);
-	if(connect(task, SIGNAL(fileAnalyzed(const QByteArray&, const QString&, const qint64&)), this, SLOT(fileDone(const QByteArray&, const QString&, const qint64&)), Qt::BlockingQueuedConnection))
+	/*all members of the same archive are read by a single task, each of them is a pending result*/
+	QString archivePath, memberName;
+	QStringList members;
+	if(ArchiveReader::splitPath(record.path, archivePath, memberName))
+	{
+		members << memberName;
+		QString nextArchive, nextMember;
+		while((!m_files.empty()) && ArchiveReader::splitPath(m_files.head().path, nextArchive, nextMember) && (nextArchive == archivePath))
+		{
+			m_files.dequeue();
+			members << nextMember;
+		}
+	}
+
+	FileComparatorTask *task = new FileComparatorTask(members.isEmpty() ? record : MAKE_FILE_RECORD(archivePath, -1, record.mtime), m_abortFlag, m_overlapDetection, m_similarityDetection, members);
+	if(connect(task, SIGNAL(fileAnalyzed(const QByteArray&, const fileRecord_t*, const qint64&, const Chunker*, const MinHash*)), this, SLOT(fileDone(const QByteArray&, const fileRecord_t*, const qint64&, const Chunker*, const MinHash*)), Qt::BlockingQueuedConnection))
 	{
-		m_pendingTasks++;
+		m_pendingTasks += qMax(1, members.count());
 		m_pool->start(task);
 	}
 }
 
-void FileComparator::fileDone(const QByteArray &hash, const QString &path, const qint64 &fileSize)
+/*archive members are moved to the end of the queue, with the members of each archive next to each other*/
+void FileComparator::groupArchiveMembers(void)
+{
+	QQueue<fileRecord_t> files;
+	QStringList archives;
+	QHash<QString, QList<fileRecord_t> > members;
+
+	for(QQueue<fileRecord_t>::ConstIterator iter = m_files.constBegin(); iter != m_files.constEnd(); iter++)
+	{
+		QString archivePath, memberName;
+		if(ArchiveReader::splitPath(iter->path, archivePath, memberName))
+		{
+			QHash<QString, QList<fileRecord_t> >::Iterator archive = members.find(archivePath);
+			if(archive == members.end())
+			{
+				archives << archivePath;
+				archive = members.insert(archivePath, QList<fileRecord_t>());
+			}
+			archive.value() << (*iter);
+			continue;
+		}
+		files << (*iter);
+	}
+
+	for(QStringList::ConstIterator iter = archives.constBegin(); iter != archives.constEnd(); iter++)
+	{
+		files << members.value(*iter);
+	}
+
+	m_files.swap(files);
+}
+
+/*members of compressed archives have been hashed while they were listed, they don't need to be read again*/
+void FileComparator::usePrecomputedHashes(void)
+{
+	if(m_memberHashes.isEmpty() || m_overlapDetection || m_similarityDetection)
+	{
+		return; /*chunks and sketches are not computed while listing*/
+	}
+
+	QQueue<fileRecord_t> files;
+	int count = 0;
+	for(QQueue<fileRecord_t>::ConstIterator iter = m_files.constBegin(); iter != m_files.constEnd(); iter++)
+	{
+		const QByteArray hash = m_memberHashes.value(iter->path);
+		if(hash.isEmpty())
+		{
+			files << (*iter);
+			continue;
+		}
+		addResult(hash, (*iter), iter->size);
+		count++;
+	}
+
+	qDebug("Using %d precomputed hash(es) of archive members.", count);
+	m_files.swap(files);
+}
+
+/*a file whose size is unique can not have a duplicate, so there is no need to read it*/
+void FileComparator::removeUniqueSizes(void)
+{
+	QHash<qint64, int> sizeCount;
+	for(QQueue<fileRecord_t>::ConstIterator iter = m_files.constBegin(); iter != m_files.constEnd(); iter++)
+	{
+		sizeCount[iter->size]++;
+	}
+
+	QQueue<fileRecord_t> candidates;
+	for(QQueue<fileRecord_t>::ConstIterator iter = m_files.constBegin(); iter != m_files.constEnd(); iter++)
+	{
+		if((iter->size < 0) || (sizeCount.value(iter->size) > 1))
+		{
+			candidates << (*iter);
+		}
+	}
+
+	qDebug("Skipping %d file(s) of unique size.", m_files.count() - candidates.count());
+	m_files.swap(candidates);
+}
+
+void FileComparator::fileDone(const QByteArray &hash, const fileRecord_t *record, const qint64 &queuedSize, const Chunker *chunker, const MinHash *minHash)
 {
-	if(!(hash.isEmpty() || path.isEmpty() || (fileSize < 0)))
+	if(record && (!(hash.isEmpty() || record->path.isEmpty() || (record->size < 0))))
 	{
-		m_hashes.insertMulti(hash, path);
-		
-		if(!m_fileSizes.contains(hash))
+		const QString &path = record->path;
+		const qint64 &fileSize = record->size;
+
+		addResult(hash, *record, queuedSize);
+
+		if(chunker)
 		{
-			m_fileSizes.insert(hash, fileSize); /*store new file size*/
+			indexChunks(hash, path, fileSize, chunker);
 		}
-		else if(m_fileSizes.value(hash) != fileSize)
+
+		if(minHash && (!m_sketchedHashes.contains(hash)))
 		{
-			qFatal("Madness: SHA-1 collission has been detected!");
+			m_sketchedHashes.insert(hash); /*identical files are reported as duplicates anyway*/
+			m_sketchedFiles << path;
+			m_sketchedSizes << fileSize;
+			m_sketches << minHash->signature();
+		}
+	}
+	else if(record && (!record->path.isEmpty()) && (m_directoryMode != DIRECTORIES_OFF))
+	{
+		m_failedFiles << record->path; /*directories containing this file are incomplete*/
+	}
+
+	if(m_streamResults && (!(*m_abortFlag)))
+	{
+		QHash<qint64, int>::Iterator pending = m_pendingSizes.find(queuedSize);
+		if((pending != m_pendingSizes.end()) && (--pending.value() < 1))
+		{
+			m_pendingSizes.erase(pending);
+			streamSize(queuedSize);
+		}
+		if(m_batchTimer.elapsed() >= STREAM_INTERVAL)
+		{
+			flushDuplicates();
 		}
 	}
 
@@ -211,7 +559,69 @@ void FileComparator::fileDone(const QByteArray &hash, const QString &path, const
 	}
 }
 
-void FileComparator::addFiles(const QStringList &files)
+void FileComparator::addResult(const QByteArray &hash, const fileRecord_t &record, const qint64 &queuedSize)
+{
+	m_hashes.insertMulti(hash, record);
+
+	if(!m_fileSizes.contains(hash))
+	{
+		m_fileSizes.insert(hash, record.size); /*store new file size*/
+		if(m_streamResults)
+		{
+			m_sizeHashes[queuedSize] << hash;
+		}
+	}
+	else if(m_fileSizes.value(hash) != record.size)
+	{
+		qFatal("Madness: SHA-1 collission has been detected!");
+	}
+}
+
+void FileComparator::queueDuplicate(const QByteArray &hash, const QList<fileRecord_t> &files)
+{
+	duplicateGroup_t group;
+	group.hash = hash;
+	group.files = files;
+	m_duplicateBatch << group;
+
+	if(m_duplicateBatch.count() >= DUPLICATE_BATCH_SIZE)
+	{
+		flushDuplicates();
+	}
+}
+
+void FileComparator::flushDuplicates(void)
+{
+	if(!m_duplicateBatch.isEmpty())
+	{
+		emit duplicatesFound(m_duplicateBatch);
+		m_duplicateBatch.clear();
+	}
+
+	if(m_batchTimer.isValid())
+	{
+		m_batchTimer.restart();
+	}
+}
+
+/*all queued files of the given size are done, so the groups of that size can not grow anymore*/
+void FileComparator::streamSize(const qint64 &size)
+{
+	const QList<QByteArray> hashes = m_sizeHashes.take(size);
+	for(QList<QByteArray>::ConstIterator iter = hashes.constBegin(); iter != hashes.constEnd(); iter++)
+	{
+		if(m_hashes.count(*iter) > 1)
+		{
+			QList<fileRecord_t> values = m_hashes.values(*iter);
+			qSort(values.begin(), values.end(), FILE_RECORD_LESS_THAN);
+			qDebug("%s -> %d", iter->toHex().constData(), values.count());
+			queueDuplicate((*iter), values);
+			m_streamedHashes.insert(*iter);
+		}
+	}
+}
+
+void FileComparator::addFiles(const QList<fileRecord_t> &files)
 {
 	if(this->isRunning())
 	{
@@ -222,6 +632,355 @@ void FileComparator::addFiles(const QStringList &files)
 	m_files << files;
 }
 
+void FileComparator::addMemberHashes(const QHash<QString, QByteArray> &memberHashes)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_memberHashes.unite(memberHashes);
+}
+
+void FileComparator::setOverlapDetection(const bool &enabled)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_overlapDetection = enabled;
+}
+
+void FileComparator::setSimilarityDetection(const bool &enabled)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_similarityDetection = enabled;
+}
+
+void FileComparator::setStreaming(const bool &enabled)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_streaming = enabled;
+}
+
+void FileComparator::setDirectoryDetection(const int &mode, const QStringList &roots)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_directoryMode = mode;
+	m_rootDirectories.clear();
+
+	for(QStringList::ConstIterator iter = roots.constBegin(); iter != roots.constEnd(); iter++)
+	{
+		const QString root = QFileInfo(*iter).canonicalFilePath();
+		if(!root.isEmpty())
+		{
+			m_rootDirectories << root; /*file paths are canonical too*/
+		}
+	}
+}
+
+void FileComparator::setPartialOutput(const QString &outFile)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_partialOutput = outFile;
+}
+
+bool FileComparator::writePartialOutput(void)
+{
+	qDebug("\n[Writing Partial Result]");
+
+	PartialResultWriter writer;
+	if(!writer.open(m_partialOutput))
+	{
+		return false;
+	}
+
+	for(QHash<QByteArray, fileRecord_t>::ConstIterator iter = m_hashes.constBegin(); iter != m_hashes.constEnd(); iter++)
+	{
+		if(!writer.write(iter.key(), iter.value()))
+		{
+			writer.close();
+			return false;
+		}
+	}
+
+	qDebug("Wrote %d records to: %s", m_hashes.count(), m_partialOutput.toUtf8().constData());
+	return writer.close();
+}
+
+void FileComparator::indexChunks(const QByteArray &hash, const QString &path, const qint64 &fileSize, const Chunker *chunker)
+{
+	const quint32 fileId = quint32(m_chunkedFiles.count());
+	const QVector<Chunker::chunk_t> &chunks = chunker->chunks();
+
+	m_chunkedFiles << path;
+	m_chunkedSizes << fileSize;
+	m_chunkedHashes << hash;
+
+	QSet<quint64> seen;
+	for(QVector<Chunker::chunk_t>::ConstIterator iter = chunks.constBegin(); iter != chunks.constEnd(); iter++)
+	{
+		if(!seen.contains(iter->hash))
+		{
+			seen.insert(iter->hash);
+			posting_t &posting = m_chunkIndex[iter->hash];
+			posting.size = iter->size;
+			posting.files << fileId;
+		}
+	}
+}
+
+void FileComparator::searchOverlaps(void)
+{
+	qDebug("\n[Searching Partial Overlaps]");
+
+	QHash<quint64, qint64> sharedBytes;
+
+	for(QHash<quint64, posting_t>::ConstIterator iter = m_chunkIndex.constBegin(); iter != m_chunkIndex.constEnd(); iter++)
+	{
+		const QVector<quint32> &files = iter->files;
+		if((files.count() < 2) || (files.count() > OVERLAP_MAX_POSTINGS))
+		{
+			continue; /*unique chunk or very common chunk, e.g. zero-filled block*/
+		}
+		for(int i = 0; i < files.count(); i++)
+		{
+			for(int j = i + 1; j < files.count(); j++)
+			{
+				if(m_chunkedHashes.at(files[i]) != m_chunkedHashes.at(files[j]))
+				{
+					sharedBytes[(quint64(qMin(files[i], files[j])) << 32) | quint64(qMax(files[i], files[j]))] += iter->size;
+				}
+			}
+		}
+		if(*m_abortFlag)
+		{
+			return;
+		}
+	}
+
+	const quint32 fileCount = quint32(m_chunkedFiles.count());
+	QVector<quint32> parent(fileCount);
+
+	for(quint32 i = 0; i < fileCount; i++)
+	{
+		parent[i] = i;
+	}
+
+	/*every member of a group shares at least this many bytes with one other member*/
+	QHash<quint64, qint64> edges;
+	for(QHash<quint64, qint64>::ConstIterator iter = sharedBytes.constBegin(); iter != sharedBytes.constEnd(); iter++)
+	{
+		const quint32 file1 = quint32(iter.key() >> 32), file2 = quint32(iter.key());
+		const qint64 smallerSize = qMin(m_chunkedSizes.at(file1), m_chunkedSizes.at(file2));
+		if((iter.value() >= OVERLAP_MIN_SHARED) && ((iter.value() * 2) >= smallerSize))
+		{
+			edges.insert(iter.key(), iter.value());
+			parent[UNION_FIND(parent, file1)] = UNION_FIND(parent, file2);
+		}
+	}
+
+	QHash<quint32, qint64> groupScore;
+	for(QHash<quint64, qint64>::ConstIterator iter = edges.constBegin(); iter != edges.constEnd(); iter++)
+	{
+		const quint32 root = UNION_FIND(parent, quint32(iter.key() >> 32));
+		groupScore[root] = groupScore.contains(root) ? qMin(groupScore[root], iter.value()) : iter.value();
+	}
+
+	QHash<quint32, QStringList> groupFiles;
+	QHash<QString, qint64> fileSizes;
+	for(quint32 i = 0; i < fileCount; i++)
+	{
+		const quint32 root = UNION_FIND(parent, i);
+		if(groupScore.contains(root))
+		{
+			groupFiles[root] << m_chunkedFiles.at(i);
+			fileSizes.insert(m_chunkedFiles.at(i), m_chunkedSizes.at(i));
+		}
+	}
+
+	QMultiMap<qint64, quint32> groups;
+	for(QHash<quint32, qint64>::ConstIterator iter = groupScore.constBegin(); iter != groupScore.constEnd(); iter++)
+	{
+		groups.insert(iter.value(), iter.key());
+	}
+
+	QMapIterator<qint64, quint32> iter(groups);
+	iter.toBack();
+
+	while(iter.hasPrevious() && (!(*m_abortFlag)))
+	{
+		iter.previous();
+		QStringList &files = groupFiles[iter.value()];
+		qSort(files.begin(), files.end(), Utilities::filePathLessThan);
+		QList<qint64> sizes;
+		for(QStringList::ConstIterator file = files.constBegin(); file != files.constEnd(); file++)
+		{
+			sizes << fileSizes.value(*file, 0);
+		}
+		emit overlapFound(files, sizes, iter.key());
+	}
+
+	qDebug("Found %d groups of partially overlapping files!", groups.count());
+}
+
+void FileComparator::searchSimilar(void)
+{
+	qDebug("\n[Searching Similar Files]");
+
+	const quint32 fileCount = quint32(m_sketches.count());
+	QHash<quint64, QVector<quint32> > buckets;
+
+	for(quint32 i = 0; i < fileCount; i++)
+	{
+		const quint32 *const sketch = m_sketches[i].constData();
+		for(int band = 0; band < LSH_BANDS; band++)
+		{
+			quint64 key = quint64(band) << 56;
+			for(int row = 0; row < LSH_ROWS; row++)
+			{
+				key = (key ^ sketch[(band * LSH_ROWS) + row]) * 0x100000001B3ui64;
+			}
+			buckets[key] << i;
+		}
+	}
+
+	QSet<quint64> checked;
+	QVector<quint32> parent(fileCount);
+	QHash<quint64, int> edges;
+
+	for(quint32 i = 0; i < fileCount; i++)
+	{
+		parent[i] = i;
+	}
+
+	for(QHash<quint64, QVector<quint32> >::ConstIterator iter = buckets.constBegin(); iter != buckets.constEnd(); iter++)
+	{
+		const QVector<quint32> &files = iter.value();
+		if((files.count() < 2) || (files.count() > SIMILAR_MAX_BUCKET))
+		{
+			continue;
+		}
+		for(int i = 0; i < files.count(); i++)
+		{
+			for(int j = i + 1; j < files.count(); j++)
+			{
+				const quint64 pairKey = (quint64(qMin(files[i], files[j])) << 32) | quint64(qMax(files[i], files[j]));
+				if(!checked.contains(pairKey))
+				{
+					checked.insert(pairKey);
+					const int similarity = MinHash::similarity(m_sketches[files[i]], m_sketches[files[j]]);
+					if(similarity >= SIMILAR_MIN_PERCENT)
+					{
+						edges.insert(pairKey, similarity);
+						parent[UNION_FIND(parent, files[i])] = UNION_FIND(parent, files[j]);
+					}
+				}
+			}
+		}
+		if(*m_abortFlag)
+		{
+			return;
+		}
+	}
+
+	/*every member of a group is at least this similar to one other member*/
+	QHash<quint32, int> groupScore;
+	for(QHash<quint64, int>::ConstIterator iter = edges.constBegin(); iter != edges.constEnd(); iter++)
+	{
+		const quint32 root = UNION_FIND(parent, quint32(iter.key() >> 32));
+		groupScore[root] = groupScore.contains(root) ? qMin(groupScore[root], iter.value()) : iter.value();
+	}
+
+	QHash<quint32, QStringList> groupFiles;
+	QHash<QString, qint64> fileSizes;
+	for(quint32 i = 0; i < fileCount; i++)
+	{
+		const quint32 root = UNION_FIND(parent, i);
+		if(groupScore.contains(root))
+		{
+			groupFiles[root] << m_sketchedFiles.at(i);
+			fileSizes.insert(m_sketchedFiles.at(i), m_sketchedSizes.at(i));
+		}
+	}
+
+	QMultiMap<int, quint32> groups;
+	for(QHash<quint32, int>::ConstIterator iter = groupScore.constBegin(); iter != groupScore.constEnd(); iter++)
+	{
+		groups.insert(iter.value(), iter.key());
+	}
+
+	QMapIterator<int, quint32> iter(groups);
+	iter.toBack();
+
+	while(iter.hasPrevious() && (!(*m_abortFlag)))
+	{
+		iter.previous();
+		QStringList &files = groupFiles[iter.value()];
+		qSort(files.begin(), files.end(), Utilities::filePathLessThan);
+		QList<qint64> sizes;
+		for(QStringList::ConstIterator file = files.constBegin(); file != files.constEnd(); file++)
+		{
+			sizes << fileSizes.value(*file, 0);
+		}
+		emit similarFound(files, sizes, iter.key());
+	}
+
+	qDebug("Found %d groups of similar files!", groups.count());
+}
+
+DirectoryTree *FileComparator::searchDirectories(void)
+{
+	qDebug("\n[Searching Duplicate Directories]");
+
+	DirectoryTree *directoryTree = new DirectoryTree(m_rootDirectories, (m_directoryMode == DIRECTORIES_CONTENT));
+
+	for(QHash<QByteArray, fileRecord_t>::ConstIterator iter = m_hashes.constBegin(); iter != m_hashes.constEnd(); iter++)
+	{
+		directoryTree->addFile(iter.value().path, iter.key(), iter.value().size);
+	}
+
+	for(QStringList::ConstIterator iter = m_failedFiles.constBegin(); iter != m_failedFiles.constEnd(); iter++)
+	{
+		directoryTree->addFailed(*iter);
+	}
+
+	directoryTree->finish();
+
+	const QList<DirectoryTree::group_t> &groups = directoryTree->groups();
+	for(QList<DirectoryTree::group_t>::ConstIterator iter = groups.constBegin(); iter != groups.constEnd(); iter++)
+	{
+		qDebug("%s -> %d", iter->hash.toHex().constData(), iter->directories.count());
+		emit directoryFound(iter->hash, iter->directories, iter->size, iter->fileCount);
+	}
+
+	qDebug("Found %d groups of duplicate directories!", groups.count());
+	return directoryTree;
+}
+
 void FileComparator::suspend(const bool bSuspend)
 {
 	m_pauseLock.lock();
@@ -247,9 +1006,12 @@ void FileComparator::sleepWhilePaused(void)
 // File Comparator Task
 //=======================================================================================
 
-FileComparatorTask::FileComparatorTask(const QString &filePath, volatile bool *abortFlag)
+FileComparatorTask::FileComparatorTask(const fileRecord_t &record, volatile bool *abortFlag, const bool &chunking, const bool &sketching, const QStringList &members)
 :
-	m_filePath(filePath),
+	m_record(record),
+	m_chunking(chunking),
+	m_sketching(sketching),
+	m_members(members),
 	m_abortFlag(abortFlag)
 {
 }
@@ -261,45 +1023,119 @@ FileComparatorTask::~FileComparatorTask(void)
 
 void FileComparatorTask::run(void)
 {
+	if(!m_members.isEmpty())
+	{
+		runArchive();
+		return;
+	}
+
 	if(*m_abortFlag)
 	{
-		emit fileAnalyzed(QByteArray(), QString(), -1);
+		emit fileAnalyzed(QByteArray(), NULL, -1, NULL, NULL);
 		return;
 	}
 	
-	qDebug("%s", m_filePath.toUtf8().constData());
+	qDebug("%s", m_record.path.toUtf8().constData());
 
-	QFile file(m_filePath);
+	QFile file(m_record.path);
 
 	if(file.open(QIODevice::ReadOnly))
 	{
 		qint64 fileSize = 0;
 		QCryptographicHash hash(QCryptographicHash::Sha1);
 
+		Chunker chunker;
+		const bool chunking = m_chunking && (m_record.size >= OVERLAP_MIN_FILESIZE);
+
+		MinHash minHash;
+		const bool sketching = m_sketching && (m_record.size >= SIMILAR_MIN_FILESIZE) && (m_record.size <= SIMILAR_MAX_FILESIZE);
+
+		QByteArray buffer;
+		buffer.resize(int(qBound(MIN_READ_SIZE, m_record.size, MAX_READ_SIZE)));
+		bool readFailed = false;
+
 		while(!(file.atEnd() || (file.error() != QFile::NoError) || (*m_abortFlag)))
 		{
-			const QByteArray buffer = file.read(4096 /*1048576*/);
-			if(buffer.size() > 0)
+			const qint64 length = file.read(buffer.data(), buffer.size());
+			if(length < 0)
+			{
+				readFailed = true;
+				break;
+			}
+			if(length > 0)
 			{
-				hash.addData(buffer);
-				fileSize += buffer.size();
+				hash.addData(buffer.constData(), int(length));
+				fileSize += length;
+				if(chunking)
+				{
+					chunker.update(buffer.constData(), length);
+				}
+				if(sketching)
+				{
+					minHash.update(buffer.constData(), length);
+				}
 			}
 		}
 	
 		const QFile::FileError error = file.error();
 		file.close();
 
-		if((error == QFile::NoError) && (!(*m_abortFlag)))
+		if((error == QFile::NoError) && (!readFailed) && (!(*m_abortFlag)))
 		{
-			emit fileAnalyzed(hash.result(), m_filePath, fileSize);
+			if(chunking)
+			{
+				chunker.finish();
+			}
+			const bool sketched = sketching && minHash.finish();
+			const fileRecord_t record = MAKE_FILE_RECORD(m_record.path, fileSize, m_record.mtime, m_record.attributes);
+			emit fileAnalyzed(hash.result(), &record, m_record.size, chunking ? &chunker : NULL, sketched ? &minHash : NULL);
 			return;
 		}
 	}
 
 	if(!(*m_abortFlag))
 	{
-		qWarning("Failed to open: %s", m_filePath.toUtf8().constData());
+		qWarning("Failed to open: %s", m_record.path.toUtf8().constData());
+	}
+
+	emit fileAnalyzed(QByteArray(), &m_record, m_record.size, NULL, NULL);
+}
+
+void FileComparatorTask::runArchive(void)
+{
+	if(*m_abortFlag)
+	{
+		for(int i = 0; i < m_members.count(); i++)
+		{
+			emit fileAnalyzed(QByteArray(), NULL, -1, NULL, NULL);
+		}
+		return;
 	}
 
-	emit fileAnalyzed(QByteArray(), QString(), -1);
+	qDebug("%s (%d members)", m_record.path.toUtf8().constData(), m_members.count());
+
+	MemberHasher hasher(m_members, m_abortFlag, m_chunking, m_sketching);
+	ArchiveReader::process(m_record.path, &hasher);
+
+	/*exactly one result must be emitted for each of the requested members*/
+	const QList<MemberHasher::member_t> &results = hasher.results();
+	for(QList<MemberHasher::member_t>::ConstIterator iter = results.constBegin(); iter != results.constEnd(); iter++)
+	{
+		const fileRecord_t record = MAKE_FILE_RECORD(ArchiveReader::makePath(m_record.path, iter->name), iter->size, m_record.mtime);
+		emit fileAnalyzed(iter->hash, &record, iter->size, iter->chunked ? &iter->chunker : NULL, iter->sketched ? &iter->minHash : NULL);
+	}
+
+	const QHash<QString, int> &pending = hasher.pending();
+	for(QHash<QString, int>::ConstIterator iter = pending.constBegin(); iter != pending.constEnd(); iter++)
+	{
+		const fileRecord_t record = MAKE_FILE_RECORD(ArchiveReader::makePath(m_record.path, iter.key()), -1, m_record.mtime);
+		if(!(*m_abortFlag))
+		{
+			qWarning("Failed to read: %s", record.path.toUtf8().constData());
+		}
+		for(int i = 0; i < iter.value(); i++)
+		{
+			emit fileAnalyzed(QByteArray(), &record, -1, NULL, NULL);
+		}
+	}
 }
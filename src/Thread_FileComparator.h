@@ -27,13 +27,21 @@
 #include <QStringList>
 #include <QQueue>
 #include <QHash>
+#include <QVector>
+#include <QSet>
 #include <QReadWriteLock>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QElapsedTimer>
+
+#include "FileRecord.h"
 
 class QThreadPool;
 class QEventLoop;
 class DuplicatesModel;
+class Chunker;
+class MinHash;
+class DirectoryTree;
 
 //=======================================================================================
 
@@ -42,16 +50,20 @@ class FileComparatorTask : public QObject, public QRunnable
 	Q_OBJECT
 
 public:
-	FileComparatorTask(const QString &filePath, volatile bool *abortFlag);
+	FileComparatorTask(const fileRecord_t &record, volatile bool *abortFlag, const bool &chunking = false, const bool &sketching = false, const QStringList &members = QStringList());
 	virtual ~FileComparatorTask(void);
 
 signals:
-	void fileAnalyzed(const QByteArray &hash, const QString &path, const qint64 &fileSize);
+	void fileAnalyzed(const QByteArray &hash, const fileRecord_t *record, const qint64 &queuedSize, const Chunker *chunker, const MinHash *minHash);
 
 protected:
 	virtual void run(void);
+	void runArchive(void);
 	
-	const QString m_filePath;
+	const fileRecord_t m_record;
+	const bool m_chunking;
+	const bool m_sketching;
+	const QStringList m_members;
 	volatile bool* const m_abortFlag;
 };
 
@@ -65,32 +77,94 @@ public:
 	FileComparator(volatile bool *abortFlag, const int &threadCount = -1);
 	virtual ~FileComparator(void);
 
-	void addFiles(const QStringList &files);
+	//Directory detection
+	typedef enum
+	{
+		DIRECTORIES_OFF     = 0,
+		DIRECTORIES_NAMES   = 1,
+		DIRECTORIES_CONTENT = 2
+	}
+	directoryMode_t;
+
+	void addFiles(const QList<fileRecord_t> &files);
+	void addMemberHashes(const QHash<QString, QByteArray> &memberHashes);
+	void setPartialOutput(const QString &outFile);
+	void setOverlapDetection(const bool &enabled);
+	void setSimilarityDetection(const bool &enabled);
+	void setDirectoryDetection(const int &mode, const QStringList &roots);
+	void setStreaming(const bool &enabled);
 	void suspend(const bool bSuspend);
 
 private slots:
-	void fileDone(const QByteArray &hash, const QString &path, const qint64 &fileSize);
+	void fileDone(const QByteArray &hash, const fileRecord_t *record, const qint64 &queuedSize, const Chunker *chunker, const MinHash *minHash);
 
 signals:
 	void progressChanged(const int &progress);
-	void duplicateFound(const QByteArray &hash, const QStringList &path, const qint64 size);
+	void duplicatesFound(const QList<duplicateGroup_t> &groups);
+	void overlapFound(const QStringList &path, const QList<qint64> &sizes, const qint64 &sharedBytes);
+	void similarFound(const QStringList &path, const QList<qint64> &sizes, const int &similarity);
+	void directoryFound(const QByteArray &hash, const QStringList &path, const qint64 &size, const int &fileCount);
 
 protected:
 	virtual void run(void);
-	void scanNextFile(const QString path);
+	void scanNextFile(const fileRecord_t record);
+	void removeUniqueSizes(void);
+	void groupArchiveMembers(void);
+	void usePrecomputedHashes(void);
+	void addResult(const QByteArray &hash, const fileRecord_t &record, const qint64 &queuedSize);
 	void sleepWhilePaused(void);
+	bool writePartialOutput(void);
+	void indexChunks(const QByteArray &hash, const QString &path, const qint64 &fileSize, const Chunker *chunker);
+	void searchOverlaps(void);
+	void searchSimilar(void);
+	DirectoryTree *searchDirectories(void);
+	void queueDuplicate(const QByteArray &hash, const QList<fileRecord_t> &files);
+	void flushDuplicates(void);
+	void streamSize(const qint64 &size);
+
+	typedef struct
+	{
+		quint32 size;
+		QVector<quint32> files;
+	}
+	posting_t;
 
 	bool m_pauseFlag;
+	bool m_overlapDetection;
+	bool m_similarityDetection;
+	int m_directoryMode;
+	bool m_streaming;
+	bool m_streamResults;
+	QStringList m_rootDirectories;
+	QString m_partialOutput;
 
 	QThreadPool*   m_pool;
 	QMutex         m_pauseLock;
 	QWaitCondition m_pauseWait;
 
-	QQueue<QString> m_files;
+	QQueue<fileRecord_t> m_files;
+	QHash<QString, QByteArray> m_memberHashes;
 	quint64 m_pendingTasks;
 
-	QHash<QByteArray, QString> m_hashes;
+	QHash<QByteArray, fileRecord_t> m_hashes;
 	QHash<QByteArray, qint64> m_fileSizes;
+	QStringList m_failedFiles;
+
+	QList<duplicateGroup_t> m_duplicateBatch;
+	QElapsedTimer m_batchTimer;
+	QHash<qint64, int> m_pendingSizes;
+	QHash<qint64, QList<QByteArray> > m_sizeHashes;
+	QSet<QByteArray> m_streamedHashes;
+
+	QHash<quint64, posting_t> m_chunkIndex;
+	QStringList m_chunkedFiles;
+	QList<qint64> m_chunkedSizes;
+	QList<QByteArray> m_chunkedHashes;
+
+	QSet<QByteArray> m_sketchedHashes;
+	QStringList m_sketchedFiles;
+	QList<qint64> m_sketchedSizes;
+	QVector<QVector<quint32> > m_sketches;
 
 	int m_totalFileCount;
 	int m_completedFileCount;
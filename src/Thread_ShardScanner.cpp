@@ -0,0 +1,449 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Thread_ShardScanner.h"
+#include "Thread_DirectoryScanner.h"
+
+#include "PartialResult.h"
+#include "Config.h"
+#include "Utilities.h"
+
+#include <QCoreApplication>
+#include <QProcess>
+#include <QDir>
+#include <QHash>
+#include <QMetaType>
+#include <QPair>
+
+static const quint64 ZERO_COUNT = 0;
+static const int DUPLICATE_BATCH_SIZE = 256;
+
+//=======================================================================================
+// Shard Scanner
+//=======================================================================================
+
+ShardScanner::ShardScanner(volatile bool *abortFlag, const int &workerCount)
+:
+	m_abortFlag(abortFlag)
+{
+	this->moveToThread(this);
+
+	m_recusrive = true;
+	m_shardByRoots = false;
+	m_archives = false;
+	m_pauseFlag = false;
+	m_fileCount = 0;
+	m_incomplete = false;
+	m_workerCount = qBound(1, workerCount, 64);
+
+	qRegisterMetaType<QList<fileRecord_t> >("QList<fileRecord_t>");
+	qRegisterMetaType<QList<duplicateGroup_t> >("QList<duplicateGroup_t>");
+}
+
+ShardScanner::~ShardScanner(void)
+{
+	//qDebug("ShardScanner deleted.");
+}
+
+void ShardScanner::run(void)
+{
+	qDebug("[Sharded Scan]");
+
+	QStringList partialFiles(m_partialInputs);
+	QStringList temporaryFiles;
+	m_fileCount = 0;
+	m_incomplete = false;
+
+	if(!m_directories.isEmpty())
+	{
+		m_directories = DirectoryScanner::pruneRoots(m_directories, m_recusrive);
+		const bool okay = runWorkers(temporaryFiles);
+		partialFiles << temporaryFiles;
+		if(!okay)
+		{
+			qWarning("At least one worker process has failed!");
+			m_incomplete = true;
+		}
+	}
+
+	if(!(*m_abortFlag))
+	{
+		sleepWhilePaused();
+		mergeResults(partialFiles);
+	}
+
+	for(QStringList::ConstIterator iter = temporaryFiles.constBegin(); iter != temporaryFiles.constEnd(); iter++)
+	{
+		QFile::remove(*iter);
+	}
+
+	m_directories.clear();
+	m_partialInputs.clear();
+
+	qDebug("Thread will exit!\n");
+}
+
+bool ShardScanner::runWorkers(QStringList &partialFiles)
+{
+	const int workerCount = m_shardByRoots ? qMin(m_workerCount, m_directories.count()) : m_workerCount;
+	const QString programFile = QCoreApplication::applicationFilePath();
+
+	QList<QProcess*> workers;
+	bool okay = true;
+
+	qDebug("Launching %d worker processes (split by %s)", workerCount, m_shardByRoots ? "roots" : "size");
+
+	for(int i = 0; i < workerCount; i++)
+	{
+		const QString outFile = QDir::temp().absoluteFilePath(QString("dblscan_%1_%2.part").arg(QString::number(QCoreApplication::applicationPid()), QString::number(i)));
+
+		QStringList args;
+		args << "--worker" << "--partial-out" << QDir::toNativeSeparators(outFile);
+		if(!m_recusrive)
+		{
+			args << "--no-recursive";
+		}
+		if(m_archives)
+		{
+			args << "--archives";
+		}
+		args << m_filter.toArguments();
+		if(!m_traversalOrder.isEmpty())
+		{
+			args << "--traversal" << m_traversalOrder;
+		}
+		if(!m_cacheFile.isEmpty())
+		{
+			/*workers split by roots walk different trees, workers split by size all walk every root; either way each one keeps a cache of its own*/
+			args << "--dir-cache" << QDir::toNativeSeparators(QString("%1.%2").arg(m_cacheFile, QString::number(i)));
+		}
+		if(!m_shardByRoots)
+		{
+			args << "--shard" << QString("%1/%2").arg(QString::number(i), QString::number(workerCount));
+		}
+		for(int j = 0; j < m_directories.count(); j++)
+		{
+			if((!m_shardByRoots) || ((j % workerCount) == i))
+			{
+				args << "--scan" << QDir::toNativeSeparators(m_directories.at(j));
+			}
+		}
+
+		QProcess *process = new QProcess();
+		process->setProcessChannelMode(QProcess::ForwardedChannels);
+		process->start(programFile, args);
+
+		if(!process->waitForStarted())
+		{
+			qWarning("Failed to launch worker process #%d!", i);
+			MY_DELETE(process);
+			okay = false;
+			continue;
+		}
+
+		partialFiles << outFile;
+		workers << process;
+	}
+
+	int finished = 0, progress = -1;
+
+	while(finished < workers.count())
+	{
+		finished = 0;
+		for(QList<QProcess*>::ConstIterator iter = workers.constBegin(); iter != workers.constEnd(); iter++)
+		{
+			if((*m_abortFlag) && ((*iter)->state() != QProcess::NotRunning))
+			{
+				(*iter)->kill();
+			}
+			if((*iter)->state() == QProcess::NotRunning || (*iter)->waitForFinished(250))
+			{
+				finished++;
+			}
+		}
+
+		const int current = qRound(double(finished) / double(qMax(workers.count(), 1)) * 90.0);
+		if((current > progress) && (!(*m_abortFlag)))
+		{
+			emit progressChanged(progress = current);
+		}
+	}
+
+	while(!workers.isEmpty())
+	{
+		QProcess *process = workers.takeFirst();
+		if((process->exitStatus() != QProcess::NormalExit) || (process->exitCode() != 0))
+		{
+			okay = false;
+		}
+		MY_DELETE(process);
+	}
+
+	return okay;
+}
+
+void ShardScanner::mergeResults(const QStringList &partialFiles)
+{
+	qDebug("\n[Merging Partial Results]");
+
+	QHash<QByteArray, QList<fileRecord_t> > hashes;
+	QHash<QByteArray, qint64> fileSizes;
+
+	QByteArray hash;
+	fileRecord_t record;
+
+	/*a partial result is merged only once it has been read completely and agrees with the results merged so far*/
+	for(QStringList::ConstIterator iter = partialFiles.constBegin(); (iter != partialFiles.constEnd()) && (!(*m_abortFlag)); iter++)
+	{
+		PartialResultReader reader;
+		if(!reader.open(*iter))
+		{
+			m_incomplete = true;
+			continue;
+		}
+
+		QList<QPair<QByteArray, fileRecord_t> > records;
+		QHash<QByteArray, qint64> recordSizes;
+		bool consistent = true;
+
+		while(consistent && reader.read(hash, record) && (!(*m_abortFlag)))
+		{
+			const qint64 knownSize = fileSizes.value(hash, recordSizes.value(hash, record.size));
+			if(knownSize != record.size)
+			{
+				consistent = false; /*same digest with a different size, the file is corrupted or has been edited*/
+				break;
+			}
+			recordSizes.insert(hash, record.size);
+			records << qMakePair(hash, record);
+		}
+
+		if(*m_abortFlag)
+		{
+			break;
+		}
+
+		if(!(consistent && reader.isComplete()))
+		{
+			qWarning("Partial result is %s, skipping: %s", consistent ? "incomplete" : "inconsistent", iter->toUtf8().constData());
+			m_incomplete = true;
+			continue;
+		}
+
+		for(QList<QPair<QByteArray, fileRecord_t> >::ConstIterator iterRecord = records.constBegin(); iterRecord != records.constEnd(); iterRecord++)
+		{
+			hashes[iterRecord->first] << iterRecord->second;
+			fileSizes.insert(iterRecord->first, iterRecord->second.size);
+			m_fileCount++;
+		}
+	}
+
+	if(*m_abortFlag)
+	{
+		return;
+	}
+
+	quint32 duplicateCount = 0;
+	QList<QByteArray> keys = hashes.keys();
+	QList<duplicateGroup_t> batch;
+	qSort(keys);
+
+	for(QList<QByteArray>::ConstIterator iter = keys.constBegin(); iter != keys.constEnd(); iter++)
+	{
+		QList<fileRecord_t> &values = hashes[*iter];
+		if(values.count() > 1)
+		{
+			qSort(values.begin(), values.end(), FILE_RECORD_LESS_THAN);
+			for(int i = values.count() - 1; i > 0; i--)
+			{
+				if(values.at(i).path == values.at(i - 1).path)
+				{
+					values.removeAt(i); /*overlapping partial results*/
+				}
+			}
+			if(values.count() > 1)
+			{
+				duplicateGroup_t group;
+				group.hash = (*iter);
+				group.files = values;
+				batch << group;
+				duplicateCount++;
+			}
+		}
+		if(batch.count() >= DUPLICATE_BATCH_SIZE)
+		{
+			emit duplicatesFound(batch);
+			batch.clear();
+		}
+	}
+
+	if(!batch.isEmpty())
+	{
+		emit duplicatesFound(batch);
+	}
+
+	qDebug("Merged %u records, found %u files with duplicates!", quint32(m_fileCount), duplicateCount);
+	emit progressChanged(100);
+}
+
+void ShardScanner::setRecursive(const bool &recusrive)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_recusrive = recusrive;
+}
+
+void ShardScanner::setArchiveMode(const bool &enabled)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_archives = enabled;
+}
+
+void ShardScanner::setTraversalOrder(const QString &order)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_traversalOrder = order;
+}
+
+void ShardScanner::setCacheFile(const QString &cacheFile)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_cacheFile = cacheFile;
+}
+
+void ShardScanner::setFilter(const ScanFilter &filter)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_filter = filter;
+}
+
+void ShardScanner::setWorkerCount(const int &workerCount)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_workerCount = qBound(1, workerCount, 64);
+}
+
+void ShardScanner::setShardByRoots(const bool &shardByRoots)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_shardByRoots = shardByRoots;
+}
+
+void ShardScanner::addDirectories(const QStringList &paths)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_directories << paths;
+}
+
+void ShardScanner::addPartialResults(const QStringList &inFiles)
+{
+	if(this->isRunning())
+	{
+		qWarning("Cannot add input while thread is still running!");
+		return;
+	}
+
+	m_partialInputs << inFiles;
+}
+
+const quint64 &ShardScanner::getFileCount(void) const
+{
+	if(this->isRunning())
+	{
+		qWarning("Result requested while thread is still running!");
+		return ZERO_COUNT;
+	}
+
+	return m_fileCount;
+}
+
+/*true if a worker has failed or a partial result had to be skipped*/
+bool ShardScanner::isIncomplete(void) const
+{
+	if(this->isRunning())
+	{
+		qWarning("Result requested while thread is still running!");
+		return true;
+	}
+
+	return m_incomplete;
+}
+
+void ShardScanner::suspend(const bool bSuspend)
+{
+	m_pauseLock.lock();
+	if(m_pauseFlag != bSuspend)
+	{
+		m_pauseFlag = bSuspend;
+		m_pauseWait.wakeAll();
+	}
+	m_pauseLock.unlock();
+}
+
+void ShardScanner::sleepWhilePaused(void)
+{
+	m_pauseLock.lock();
+	while(m_pauseFlag)
+	{
+		m_pauseWait.wait(&m_pauseLock);
+	}
+	m_pauseLock.unlock();
+}
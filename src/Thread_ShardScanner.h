@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Double File Scanner
+// Copyright (C) 2014-2017 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version, but always including the *additional*
+// restrictions defined in the "License.txt" file.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QThread>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "FileRecord.h"
+#include "ScanFilter.h"
+
+//=======================================================================================
+
+class ShardScanner : public QThread
+{
+	Q_OBJECT
+
+public:
+	ShardScanner(volatile bool *abortFlag, const int &workerCount = 2);
+	virtual ~ShardScanner(void);
+
+	void setRecursive(const bool &recusrive);
+	void setWorkerCount(const int &workerCount);
+	void setShardByRoots(const bool &shardByRoots);
+	void setArchiveMode(const bool &enabled);
+	void setFilter(const ScanFilter &filter);
+	void setCacheFile(const QString &cacheFile);
+	void setTraversalOrder(const QString &order);
+	void addDirectories(const QStringList &paths);
+	void addPartialResults(const QStringList &inFiles);
+	void suspend(const bool bSuspend);
+
+	const quint64 &getFileCount(void) const;
+	bool isIncomplete(void) const;
+
+signals:
+	void progressChanged(const int &progress);
+	void duplicatesFound(const QList<duplicateGroup_t> &groups);
+
+protected:
+	virtual void run(void);
+	bool runWorkers(QStringList &partialFiles);
+	void mergeResults(const QStringList &partialFiles);
+	void sleepWhilePaused(void);
+
+	bool m_recusrive;
+	bool m_shardByRoots;
+	bool m_archives;
+	ScanFilter m_filter;
+	QString m_cacheFile;
+	QString m_traversalOrder;
+	bool m_pauseFlag;
+	int m_workerCount;
+
+	QMutex         m_pauseLock;
+	QWaitCondition m_pauseWait;
+
+	QStringList m_directories;
+	QStringList m_partialInputs;
+	quint64 m_fileCount;
+	bool m_incomplete;
+
+	volatile bool *const m_abortFlag;
+};
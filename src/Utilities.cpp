@@ -24,6 +24,8 @@
 
 #include "Utilities.h"
 
+#include "strnatcmp/strnatcmp.h"
+
 QString Utilities::sizeToString(const qint64 &size)
 {
 	static const struct
@@ -50,3 +52,23 @@ QString Utilities::sizeToString(const qint64 &size)
 
 	return QString().sprintf("%.2f %s", double(size)/double(SIZE[idx].size), SIZE[idx].suffix);
 }
+
+bool Utilities::filePathLessThan(const QString &s1, const QString &s2)
+{
+	int result = 0;
+
+	const wchar_t *file1 = wcsrchr((const wchar_t*) s1.utf16(), L'/');
+	const wchar_t *file2 = wcsrchr((const wchar_t*) s2.utf16(), L'/');
+
+	if(file1 && file2)
+	{
+		result = strnatcasecmp(++file1, ++file2);
+	}
+
+	if(result == 0)
+	{
+		result = strnatcasecmp((const wchar_t*) s1.utf16(), (const wchar_t*) s2.utf16());
+	}
+
+	return (result < 0);
+}
@@ -28,6 +28,7 @@ class Utilities
 {
 public:
 	static QString sizeToString(const qint64 &size);
+	static bool filePathLessThan(const QString &s1, const QString &s2);
 	
 private:
 	Utilities(void) {}
@@ -233,3 +233,23 @@ bool DirectoriesDialog::getRecursive(void)
 {
 	return ui->checkBoxRecursive->isChecked();
 }
+
+bool DirectoriesDialog::getOverlapDetection(void)
+{
+	return ui->checkBoxOverlaps->isChecked();
+}
+
+bool DirectoriesDialog::getSimilarityDetection(void)
+{
+	return ui->checkBoxSimilar->isChecked();
+}
+
+bool DirectoriesDialog::getDirectoryDetection(void)
+{
+	return ui->checkBoxDirectories->isChecked();
+}
+
+bool DirectoriesDialog::getArchiveMode(void)
+{
+	return ui->checkBoxArchives->isChecked();
+}
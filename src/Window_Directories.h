@@ -43,6 +43,10 @@ public:
 	QStringList getDirectories(void);
 	void addDirectories(const QStringList &directories);
 	bool getRecursive(void);
+	bool getOverlapDetection(void);
+	bool getSimilarityDetection(void);
+	bool getDirectoryDetection(void);
+	bool getArchiveMode(void);
 
 private slots:
 	void addDirectory(void);
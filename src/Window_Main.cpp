@@ -27,10 +27,15 @@
 #include "System.h"
 #include "Thread_DirectoryScanner.h"
 #include "Thread_FileComparator.h"
+#include "Thread_ShardScanner.h"
+#include "Thread_DirectoryWatcher.h"
 #include "Model_Duplicates.h"
 #include "Window_Directories.h"
 #include "Utilities.h"
 #include "Taskbar.h"
+#include "ArchiveReader.h"
+#include "ResultStore.h"
+#include "ScanFilter.h"
 
 #include <QCloseEvent>
 #include <QFileDialog>
@@ -55,19 +60,58 @@ static void UNSET_MODEL(QTreeView *view)
 	MY_DELETE(selectionModel);
 }
 
+/*column widths are derived from a sample of the groups and their first file, instead of measuring every row*/
+static void RESIZE_COLUMNS(QTreeView *view, QAbstractItemModel *model)
+{
+	static const int SAMPLE_COUNT = 128;
+	const int rowCount = model->rowCount();
+	const int step = qMax(1, rowCount / SAMPLE_COUNT);
+	int width[2] = { 0, 0 };
+
+	for(int i = 0; i < rowCount; i += step)
+	{
+		const QModelIndex group = model->index(i, 0);
+		width[0] = qMax(width[0], view->sizeHintForIndex(group).width());
+		if(model->rowCount(group) > 0)
+		{
+			width[0] = qMax(width[0], view->sizeHintForIndex(model->index(0, 0, group)).width() + view->indentation());
+			width[1] = qMax(width[1], view->sizeHintForIndex(model->index(0, 2, group)).width());
+		}
+	}
+
+	if(QHeaderView *header = view->header())
+	{
+		header->resizeSection(0, qMax(width[0] + view->indentation(), header->sectionSizeHint(0)));
+		header->resizeSection(2, qMax(width[1], header->sectionSizeHint(2)));
+	}
+}
+
+static const int AUTO_EXPAND_LIMIT = 256;
+
+/*fits the columns to the current groups and expands them, unless there are too many*/
+static void FIT_VIEW(QTreeView *view, QAbstractItemModel *model)
+{
+	RESIZE_COLUMNS(view, model);
+	if((!model->canFetchMore(QModelIndex())) && (model->rowCount() <= AUTO_EXPAND_LIMIT))
+	{
+		view->expandAll(); /*large results are expanded on demand only*/
+	}
+}
+
 static void SETUP_MODEL(QTreeView *view, QAbstractItemModel *model)
 {
 	UNSET_MODEL(view);
+	view->setUniformRowHeights(true);
 	view->setModel(model);
 	if(QHeaderView *header = view->header())
 	{
-		header->setResizeMode(0, QHeaderView::ResizeToContents);
+		header->setResizeMode(0, QHeaderView::Interactive);
 		header->setResizeMode(1, QHeaderView::Stretch);
-		header->setResizeMode(2, QHeaderView::ResizeToContents);
+		header->setResizeMode(2, QHeaderView::Interactive);
 		header->setMovable(false);
-		header->setClickable(false);
 	}
-	view->expandAll();
+	view->setSortingEnabled(true); /*re-applies the current sort indicator, -1 keeps the original order*/
+	FIT_VIEW(view, model);
 }
 
 static void ENABLE_MENU(QMenu *menu, const bool &enabled)
@@ -79,14 +123,26 @@ static void ENABLE_MENU(QMenu *menu, const bool &enabled)
 	}
 }
 
+static inline bool IS_ARCHIVE_MEMBER(const QString &filePath)
+{
+	QString archivePath, memberName;
+	return ArchiveReader::splitPath(filePath, archivePath, memberName);
+}
+
 static bool DELETE_ALL_BUT_ONE(DuplicatesModel *model, const QModelIndex &group, qint64 *size)
 {
-	int fileCount, currentIndex;
-	fileCount = currentIndex = model->rowCount(group);
+	int fileCount = 0, currentIndex = model->rowCount(group);
+	for(int i = 0; i < currentIndex; i++)
+	{
+		if(!IS_ARCHIVE_MEMBER(model->getFilePath(model->index(i, 0, group))))
+		{
+			fileCount++; /*archive members are never deleted, so they don't count as a remaining copy*/
+		}
+	}
 	while((fileCount > 1) && (currentIndex > 0))
 	{
 		const QModelIndex fileIndex = model->index(--currentIndex, 0, group);
-		if(fileIndex.isValid())
+		if(fileIndex.isValid() && (!IS_ARCHIVE_MEMBER(model->getFilePath(fileIndex))))
 		{
 			const qint64 currentSize = model->getFileSize(fileIndex);
 			if(model->deleteFile(fileIndex))
@@ -113,6 +169,7 @@ static bool DELETE_ALL_BUT_ONE(DuplicatesModel *model, const QModelIndex &group,
 while(0)
 
 static const char HOMEPAGE_URL[] = "http://muldersoft.com/";
+static const int SEARCH_DELAY = 200;
 
 //===================================================================
 // Constructor & Destructor
@@ -122,11 +179,21 @@ MainWindow::MainWindow(void)
 :
 	ui(new Ui::MainWindow())
 {
-	m_abortFlag = m_runningFlag = m_pauseFlag = m_unattendedFlag = false;
+	m_abortFlag = m_runningFlag = m_pauseFlag = m_unattendedFlag = m_shardMode = false;
+	m_recursiveFlag = true;
+	m_overlapFlag = false;
+	m_similarFlag = false;
+	m_archiveFlag = false;
+	m_watchFlag = false;
+	m_streamFlag = false;
+	m_directoryMode = FileComparator::DIRECTORIES_OFF;
 	
 	//Determine threads count
 	const int threadCount = qBound(0, getEnvString("DBLSCAN_THREADS").toInt(), 64);
 
+	//Determine worker process count
+	m_workerCount = qBound(0, getEnvString("DBLSCAN_WORKERS").toInt(), 64);
+
 	//Setup window flags
 	setWindowFlags((windowFlags() | Qt::CustomizeWindowHint) & ~Qt::WindowMaximizeButtonHint);
 
@@ -148,6 +215,7 @@ MainWindow::MainWindow(void)
 	connect(ui->actionStart,     SIGNAL(triggered()), this, SLOT(startScan()));
 	connect(ui->actionClear,     SIGNAL(triggered()), this, SLOT(clearData()));
 	connect(ui->actionAutoClean, SIGNAL(triggered()), this, SLOT(autoClean()));
+	connect(ui->actionFilter,    SIGNAL(triggered()), this, SLOT(filterResults()));
 	connect(ui->actionExit,      SIGNAL(triggered()), this, SLOT(close()));
 	connect(ui->actionOpen,      SIGNAL(triggered()), this, SLOT(openFile()));
 	connect(ui->actionGoto,      SIGNAL(triggered()), this, SLOT(gotoFile()));
@@ -169,12 +237,37 @@ MainWindow::MainWindow(void)
 	m_fileComparator = new FileComparator(&m_abortFlag, threadCount);
 	connect(m_fileComparator, SIGNAL(finished()), this, SLOT(fileComparatorFinished()), Qt::QueuedConnection);
 	connect(m_fileComparator, SIGNAL(progressChanged(int)), this, SLOT(fileComparatorProgressChanged(int)), Qt::QueuedConnection);
-	connect(m_fileComparator, SIGNAL(duplicateFound(const QByteArray&, const QStringList&, const qint64&)), m_model, SLOT(addDuplicate(const QByteArray, const QStringList, const qint64&)), Qt::BlockingQueuedConnection);
+	connect(m_fileComparator, SIGNAL(duplicatesFound(const QList<duplicateGroup_t>&)), m_model, SLOT(addDuplicates(const QList<duplicateGroup_t>&)), Qt::BlockingQueuedConnection);
+	connect(m_fileComparator, SIGNAL(overlapFound(const QStringList&, const QList<qint64>&, const qint64&)), m_model, SLOT(addOverlap(const QStringList&, const QList<qint64>&, const qint64&)), Qt::BlockingQueuedConnection);
+	connect(m_fileComparator, SIGNAL(similarFound(const QStringList&, const QList<qint64>&, const int&)), m_model, SLOT(addSimilar(const QStringList&, const QList<qint64>&, const int&)), Qt::BlockingQueuedConnection);
+	connect(m_fileComparator, SIGNAL(directoryFound(const QByteArray&, const QStringList&, const qint64&, const int&)), m_model, SLOT(addDirectory(const QByteArray&, const QStringList&, const qint64&, const int&)), Qt::BlockingQueuedConnection);
+
+	//Create shard scanner
+	m_shardScanner = new ShardScanner(&m_abortFlag);
+	connect(m_shardScanner, SIGNAL(finished()), this, SLOT(fileComparatorFinished()), Qt::QueuedConnection);
+	connect(m_shardScanner, SIGNAL(progressChanged(int)), this, SLOT(fileComparatorProgressChanged(int)), Qt::QueuedConnection);
+	connect(m_shardScanner, SIGNAL(duplicatesFound(const QList<duplicateGroup_t>&)), m_model, SLOT(addDuplicates(const QList<duplicateGroup_t>&)), Qt::BlockingQueuedConnection);
+
+	//Create directory watcher
+	m_directoryWatcher = new DirectoryWatcher();
+	connect(m_directoryWatcher, SIGNAL(groupChanged(const ResultStore::change_t&)), this, SLOT(watchedGroupChanged(const ResultStore::change_t&)), Qt::QueuedConnection);
+
+	//Create scan filter
+	m_scanFilter = new ScanFilter();
 
 	//Setup tree view
 	ui->treeView->setExpandsOnDoubleClick(false);
+	ui->treeView->header()->setSortIndicator(-1, Qt::DescendingOrder);
 	connect(ui->treeView, SIGNAL(activated(QModelIndex)), this, SLOT(openFile(QModelIndex)));
 
+	//Setup search box, the filter is applied once the user stops typing
+	m_searchTimer = new QTimer();
+	m_searchTimer->setSingleShot(true);
+	m_searchTimer->setInterval(SEARCH_DELAY);
+	connect(ui->searchEdit, SIGNAL(textChanged(QString)), m_searchTimer, SLOT(start()));
+	connect(ui->searchEdit, SIGNAL(returnPressed()), this, SLOT(searchResults()));
+	connect(m_searchTimer, SIGNAL(timeout()), this, SLOT(searchResults()));
+
 	//Setup animator
 	m_movie = new QMovie(":/res/Spinner.gif");
 	m_animator = makeLabel(ui->treeView, ":/res/Spinner.gif");
@@ -204,6 +297,9 @@ MainWindow::~MainWindow(void)
 {
 	delete ui;
 
+	MY_DELETE(m_directoryWatcher);
+	MY_DELETE(m_shardScanner);
+	MY_DELETE(m_scanFilter);
 	MY_DELETE(m_fileComparator);
 	MY_DELETE(m_directoryScanner);
 	MY_DELETE(m_movie);
@@ -213,6 +309,7 @@ MainWindow::~MainWindow(void)
 	MY_DELETE(m_signCancelled);
 	MY_DELETE(m_signQuiescent);
 	MY_DELETE(m_timer);
+	MY_DELETE(m_searchTimer);
 }
 
 //===================================================================
@@ -255,6 +352,7 @@ void MainWindow::keyPressEvent(QKeyEvent *e)
 			m_abortFlag = true;
 			m_directoryScanner->suspend(false);
 			m_fileComparator  ->suspend(false);
+			m_shardScanner    ->suspend(false);
 		}
 	}
 	else if(e->key() == Qt::Key_Pause)
@@ -317,14 +415,25 @@ void MainWindow::startScan(void)
 {
 	ENSURE_APP_IS_IDLE();
 
-	bool recursive = true;
-	QStringList directories;
+	bool recursive = true, overlaps = false, similar = false;
+	int directoryMode = FileComparator::DIRECTORIES_OFF;
+	bool archives = false;
+	QStringList directories, partialInputs, fileLists;
 
 	if(m_unattendedFlag)
 	{
 		m_unattendedFlag = false;
+		recursive = m_recursiveFlag;
+		overlaps = m_overlapFlag;
+		similar = m_similarFlag;
+		directoryMode = m_directoryMode;
+		archives = m_archiveFlag;
 		directories << m_droppedFolders;
+		partialInputs << m_partialInputs;
+		fileLists << m_fileLists;
 		m_droppedFolders.clear();
+		m_partialInputs.clear();
+		m_fileLists.clear();
 	}
 	else
 	{
@@ -339,31 +448,89 @@ void MainWindow::startScan(void)
 		if(directoriesDialog->exec() == QDialog::Accepted)
 		{
 			recursive = directoriesDialog->getRecursive();
+			overlaps = directoriesDialog->getOverlapDetection();
+			similar = directoriesDialog->getSimilarityDetection();
+			directoryMode = directoriesDialog->getDirectoryDetection() ? FileComparator::DIRECTORIES_NAMES : FileComparator::DIRECTORIES_OFF;
+			archives = directoriesDialog->getArchiveMode();
 			directories << directoriesDialog->getDirectories();
 		}
 
 		MY_DELETE(directoriesDialog);
 	}
 
-	if(!directories.isEmpty())
+	if(!(directories.isEmpty() && partialInputs.isEmpty() && fileLists.isEmpty()))
 	{
 		setButtonsEnabled(false);
 		setMenuItemsEnabled(false);
+
+		m_directoryWatcher->stop();
+		m_directoryWatcher->wait();
 		
 		m_runningFlag = true;
 		m_abortFlag = m_pauseFlag = false;
+		m_shardMode = ((m_workerCount > 1) && m_partialOutput.isEmpty() && fileLists.isEmpty()) || (!partialInputs.isEmpty());
 
 		UNSET_MODEL(ui->treeView);
-		ui->label->setText(tr("Searching for files and directories, please be patient..."));
 		m_model->clear();
+		ui->searchEdit->clear();
 
 		showSign(-1);
-		updateProgress(-1);
 
-		m_directoryScanner->setRecursive(recursive);
-		m_directoryScanner->addDirectories(directories);
-		m_directoryScanner->suspend(false);
-		m_directoryScanner->start();
+		if((m_workerCount > 1) && (!fileLists.isEmpty()))
+		{
+			qWarning("File lists can not be split across worker processes, scanning in-process!");
+		}
+
+		if(m_shardMode && overlaps)
+		{
+			qWarning("Partial overlap detection is not available in sharded mode!");
+		}
+
+		if(m_shardMode && similar)
+		{
+			qWarning("Similar file detection is not available in sharded mode!");
+		}
+
+		if((m_shardMode || (!recursive)) && (directoryMode != FileComparator::DIRECTORIES_OFF))
+		{
+			qWarning("Duplicate directory detection requires a recursive, non-sharded scan!");
+			directoryMode = FileComparator::DIRECTORIES_OFF;
+		}
+
+		if(m_shardMode)
+		{
+			ui->label->setText(directories.isEmpty() ? tr("Merging partial results, please be patient...") : tr("Scanning with %1 worker processes, please be patient...").arg(QString::number(qMax(m_workerCount, 1))));
+			updateProgress(0);
+
+			m_shardScanner->setRecursive(recursive);
+			m_shardScanner->setArchiveMode(archives);
+			m_shardScanner->setFilter(*m_scanFilter);
+			m_shardScanner->setWorkerCount(m_workerCount);
+			m_shardScanner->addDirectories(directories);
+			m_shardScanner->addPartialResults(partialInputs);
+			m_shardScanner->suspend(false);
+			m_shardScanner->start();
+		}
+		else
+		{
+			ui->label->setText(tr("Searching for files and directories, please be patient..."));
+			updateProgress(-1);
+
+			m_fileComparator->setOverlapDetection(overlaps);
+			m_fileComparator->setSimilarityDetection(similar);
+			m_fileComparator->setDirectoryDetection(directoryMode, directories);
+			m_fileComparator->setStreaming(m_streamFlag);
+			m_directoryScanner->setRecursive(recursive);
+			m_directoryScanner->setArchiveMode(archives);
+			m_directoryScanner->setFilter(*m_scanFilter);
+			m_directoryScanner->addDirectories(directories);
+			m_directoryScanner->addFileLists(fileLists);
+			m_directoryScanner->suspend(false);
+			m_directoryScanner->start();
+			m_directoryWatcher->setRecursive(recursive);
+			m_directoryWatcher->setFilter(*m_scanFilter);
+			m_directoryWatcher->setDirectories(directories);
+		}
 
 		m_timer->start();
 	}
@@ -382,13 +549,19 @@ void MainWindow::directoryScannerFinished(void)
 		showSign(2);
 		setButtonsEnabled(true);
 		Taskbar::setTaskbarState(this, Taskbar::TaskbarErrorState);
+		closeIfWorker();
 		return;
 	}
 
-	const QStringList &files = m_directoryScanner->getFiles();
-	ui->label->setText(tr("%1 file(s) are being analyzed, this might take a few minutes...").arg(QString::number(files.count())));
+	ui->label->setText(tr("%1 file(s) are being analyzed, this might take a few minutes...").arg(QString::number(m_directoryScanner->getFileCount())));
+
+	if(m_streamFlag)
+	{
+		SETUP_MODEL(ui->treeView, m_model); /*final groups show up while the files are still analyzed*/
+	}
 
-	m_fileComparator->addFiles(files);
+	m_fileComparator->addFiles(m_directoryScanner->getFiles());
+	m_fileComparator->addMemberHashes(m_directoryScanner->getMemberHashes());
 	m_fileComparator->suspend(false);
 	m_fileComparator->start();
 }
@@ -405,6 +578,7 @@ void MainWindow::fileComparatorFinished(void)
 		showSign(2);
 		setButtonsEnabled(true);
 		Taskbar::setTaskbarState(this, Taskbar::TaskbarErrorState);
+		closeIfWorker();
 		return;
 	}
 
@@ -415,12 +589,69 @@ void MainWindow::fileComparatorFinished(void)
 		qDebug("Operation took %.3f seconds to complete.\n", double(elapsed) / 1000.0);
 	}
 
-	const QStringList &files = m_directoryScanner->getFiles();
-	ui->label->setText(tr("Completed: %1 file(s) have been analyzed, %2 duplicate(s) have been identified.").arg(QString::number(files.count()), QString::number(m_model->duplicateCount())));
+	const quint64 fileCount = m_shardMode ? m_shardScanner->getFileCount() : m_directoryScanner->getFileCount();
+	const unsigned int duplicateCount = m_model->duplicateCount();
+	const bool watching = m_watchFlag && (!m_shardMode) && m_partialOutput.isEmpty();
+	const bool incomplete = m_shardMode && m_shardScanner->isIncomplete();
 
-	if(m_model->duplicateCount() > 0)
+	/*the index is seeded before the result store may reduce the model to the changes*/
+	if(watching)
 	{
-		SETUP_MODEL(ui->treeView, m_model);
+		m_directoryWatcher->seed(m_directoryScanner->getFiles(), m_model->duplicateGroups());
+	}
+
+	if(!incomplete)
+	{
+		updateResultStore();
+	}
+	else if(!(m_storeFile.isEmpty() && m_diffFile.isEmpty()))
+	{
+		qWarning("Result is incomplete, the result store is not updated!");
+	}
+
+	ui->label->setText(tr("Completed: %1 file(s) have been analyzed, %2 duplicate(s) have been identified.").arg(QString::number(fileCount), QString::number(duplicateCount)));
+
+	if(const unsigned int overlapCount = m_model->groupCount(DuplicatesModel::GROUP_OVERLAP))
+	{
+		ui->label->setText(ui->label->text() + tr(" %1 partial overlap(s) have been found.").arg(QString::number(overlapCount)));
+	}
+
+	if(const unsigned int similarCount = m_model->groupCount(DuplicatesModel::GROUP_SIMILAR))
+	{
+		ui->label->setText(ui->label->text() + tr(" %1 group(s) of similar files have been found.").arg(QString::number(similarCount)));
+	}
+
+	if(const unsigned int directoryCount = m_model->groupCount(DuplicatesModel::GROUP_DIRECTORY))
+	{
+		ui->label->setText(ui->label->text() + tr(" %1 group(s) of duplicate directories have been found.").arg(QString::number(directoryCount)));
+	}
+
+	if(!m_diffFile.isEmpty())
+	{
+		ui->label->setText(ui->label->text() + tr(" Since the previous run: %1 new, %2 grown, %3 changed and %4 resolved group(s).").arg(QString::number(m_model->changeCount(ResultStore::CHANGE_NEW)), QString::number(m_model->changeCount(ResultStore::CHANGE_GROWN)), QString::number(m_model->changeCount(ResultStore::CHANGE_CHANGED)), QString::number(m_model->changeCount(ResultStore::CHANGE_RESOLVED))));
+	}
+
+	if(incomplete)
+	{
+		ui->label->setText(ui->label->text() + tr(" Warning: At least one partial result is missing or damaged, the result is incomplete!"));
+	}
+
+	if(watching)
+	{
+		ui->label->setText(ui->label->text() + tr(" Watching for changes..."));
+		m_directoryWatcher->start();
+	}
+
+	if(m_model->rowCount() > 0)
+	{
+		if(ui->treeView->model() != m_model)
+		{
+			SETUP_MODEL(ui->treeView, m_model);
+		}
+		else
+		{
+			FIT_VIEW(ui->treeView, m_model); /*streamed groups were added after the view had been set up*/
+		}
 		setMenuItemsEnabled(true);
 	}
 	else
@@ -430,6 +661,23 @@ void MainWindow::fileComparatorFinished(void)
 
 	setButtonsEnabled(true);
 	QApplication::beep();
+	closeIfWorker();
+}
+
+void MainWindow::watchedGroupChanged(const ResultStore::change_t &change)
+{
+	if(ui->treeView->model() != m_model)
+	{
+		showSign(-1);
+		SETUP_MODEL(ui->treeView, m_model);
+		setMenuItemsEnabled(true);
+	}
+
+	const QModelIndex group = m_model->updateChange(change);
+	if(group.isValid())
+	{
+		ui->treeView->expand(group);
+	}
 }
 
 void MainWindow::fileComparatorProgressChanged(const int &progress)
@@ -456,9 +704,13 @@ void MainWindow::openFile(const QModelIndex &index)
 {
 	ENSURE_APP_IS_IDLE();
 
-	const QString &filePath = m_model->getFilePath(index);
+	QString filePath = m_model->getFilePath(index), archivePath, memberName;
 	if(!filePath.isEmpty())
 	{
+		if(ArchiveReader::splitPath(filePath, archivePath, memberName))
+		{
+			filePath = archivePath; /*open the archive instead*/
+		}
 		QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
 	}
 	else
@@ -485,9 +737,13 @@ void MainWindow::gotoFile(const QModelIndex &index)
 {
 	ENSURE_APP_IS_IDLE();
 
-	const QString &filePath = m_model->getFilePath(index);
+	QString filePath = m_model->getFilePath(index), archivePath, memberName;
 	if(!filePath.isEmpty())
 	{
+		if(ArchiveReader::splitPath(filePath, archivePath, memberName))
+		{
+			filePath = archivePath; /*show the archive instead*/
+		}
 		if(QFileInfo(filePath).exists())
 		{
 			shellExplore((const wchar_t*)QDir::toNativeSeparators(filePath).utf16());
@@ -524,7 +780,11 @@ void MainWindow::renameFile(const QModelIndex &index)
 	const QString &filePath = m_model->getFilePath(index);
 	if(!filePath.isEmpty())
 	{
-		if(QFileInfo(filePath).exists() && QFileInfo(filePath).isFile())
+		if(IS_ARCHIVE_MEMBER(filePath))
+		{
+			QMessageBox::warning(this, tr("Warning"), tr("Sorry, files inside of an archive cannot be renamed!"));
+		}
+		else if(QFileInfo(filePath).exists() && QFileInfo(filePath).isFile())
 		{
 			QString targetName = QFileInfo(filePath).fileName();
 			
@@ -583,7 +843,11 @@ void MainWindow::deleteFile(const QModelIndex &index)
 	ENSURE_APP_IS_IDLE();
 
 	const QString &filePath = m_model->getFilePath(index);
-	if(!filePath.isEmpty())
+	if(IS_ARCHIVE_MEMBER(filePath))
+	{
+		QMessageBox::warning(this, tr("Warning"), tr("Sorry, files inside of an archive cannot be deleted!"));
+	}
+	else if(!filePath.isEmpty())
 	{
 		const QString text = QString("<nobr>%1</nobr><br><br><tt style=\"white-space:pre-wrap\">%2</tt>").arg(tr("Do you really want to permanently delete the selected file?"), QDir::toNativeSeparators(filePath));
 		if(QMessageBox::question(this, tr("Delete File"), text, QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::Yes)
@@ -614,9 +878,13 @@ void MainWindow::clearData(void)
 
 	if(ui->treeView->model() || m_signCancelled->isVisible() || m_signCompleted->isVisible())
 	{
+		m_directoryWatcher->stop();
+		m_directoryWatcher->wait();
+
 		UNSET_MODEL(ui->treeView);
 		setMenuItemsEnabled(false);
 		m_model->clear();
+		ui->searchEdit->clear();
 
 		updateProgress(0);
 		Taskbar::setTaskbarState(this, Taskbar::TaskbarNoState);
@@ -659,6 +927,31 @@ void MainWindow::copyToClipboard(void)
 	QApplication::beep();
 }
 
+void MainWindow::filterResults(void)
+{
+	ENSURE_APP_IS_IDLE();
+
+	bool ok = false;
+	const QString text = QInputDialog::getText(this, tr("Filter Results"), tr("Show only the groups with a file whose path contains this text, e.g. \"photos >10M <1G\":").leftJustified(128), QLineEdit::Normal, ui->searchEdit->text(), &ok);
+	if(ok)
+	{
+		m_searchTimer->stop();
+		ui->searchEdit->blockSignals(true);
+		ui->searchEdit->setText(text);
+		ui->searchEdit->blockSignals(false);
+		applyFilter(text);
+	}
+}
+
+void MainWindow::searchResults(void)
+{
+	m_searchTimer->stop();
+	if(ui->searchEdit->isEnabled() && ui->treeView->model())
+	{
+		applyFilter(ui->searchEdit->text());
+	}
+}
+
 void MainWindow::showHomepage(void)
 {
 	ENSURE_APP_IS_IDLE();
@@ -691,6 +984,11 @@ void MainWindow::autoClean(void)
 	showSign(-1);
 
 	qint64 spaceSaved = 0;
+	while(m_model->canFetchMore(QModelIndex()))
+	{
+		m_model->fetchMore(QModelIndex());
+	}
+
 	const int groupCount = m_model->rowCount();
 	qDebug("[Automatic Clean-Up]");
 
@@ -699,7 +997,7 @@ void MainWindow::autoClean(void)
 		updateProgress(i, groupCount);
 		QApplication::processEvents();
 		const QModelIndex currentGroup = m_model->index(i, 0);
-		if(currentGroup.isValid())
+		if(currentGroup.isValid() && (m_model->getGroupType(currentGroup) == DuplicatesModel::GROUP_DUPLICATE))
 		{
 			qDebug("Deleting duplicates for %s", m_model->getGroupHash(currentGroup).toHex().constData());
 			if(!DELETE_ALL_BUT_ONE(m_model, currentGroup, &spaceSaved))
@@ -810,10 +1108,35 @@ void MainWindow::setButtonsEnabled(const bool &enabled)
 	}
 }
 
+/*the text may contain ">size" and "<size" terms, everything else must be part of a file path*/
+void MainWindow::applyFilter(const QString &text)
+{
+	QStringList pathTerms;
+	qint64 minSize = -1, maxSize = -1;
+	const QStringList terms = text.split(QLatin1Char(' '), QString::SkipEmptyParts);
+	for(QStringList::ConstIterator iter = terms.constBegin(); iter != terms.constEnd(); iter++)
+	{
+		const qint64 size = ((iter->length() > 1) && ((iter->at(0) == QLatin1Char('>')) || (iter->at(0) == QLatin1Char('<')))) ? ScanFilter::parseSize(iter->mid(1)) : -1;
+		if(size >= 0)
+		{
+			((iter->at(0) == QLatin1Char('>')) ? minSize : maxSize) = size;
+			continue;
+		}
+		pathTerms << (*iter);
+	}
+
+	m_model->setGroupFilter(pathTerms.join(QString(QLatin1Char(' '))), minSize, maxSize);
+
+	/*the groups are shown as a whole, expanding them shows the matching files along with their duplicates*/
+	FIT_VIEW(ui->treeView, m_model);
+}
+
 void MainWindow::setMenuItemsEnabled(const bool &enabled)
 {
 	ENABLE_MENU(ui->menuEdit, enabled);
 	ui->actionAutoClean->setEnabled(enabled);
+	ui->actionFilter->setEnabled(enabled);
+	ui->searchEdit->setEnabled(enabled);
 	ui->actionExport->setEnabled(enabled);
 	ui->actionClipbrd->setEnabled(enabled);
 	ui->actionClear->setEnabled(enabled);
@@ -886,33 +1209,194 @@ QLabel *MainWindow::makeLabel(QWidget *parent, const QString &fileName, const bo
 void MainWindow::handleCommandLineArgs(void)
 {
 	m_droppedFolders.clear();
+	m_partialInputs.clear();
+	m_fileLists.clear();
 	const QStringList args = QApplication::arguments();
-	bool appendNext = false;
 
-	for(QStringList::ConstIterator iter = args.constBegin(); iter != args.constEnd(); iter++)
+	for(int i = 1; i < args.count(); i++)
 	{
-		if(appendNext)
+		const QString &current = args.at(i);
+		const bool hasValue = (i + 1 < args.count());
+
+		if((current.compare("--scan", Qt::CaseInsensitive) == 0) && hasValue)
 		{
-			QFileInfo folder(QDir::fromNativeSeparators(*iter));
+			QFileInfo folder(QDir::fromNativeSeparators(args.at(++i)));
 			if(folder.exists() && folder.isDir())
 			{
 				m_droppedFolders << folder.canonicalFilePath();
 			}
-			appendNext = false;
 		}
-		else if((*iter).compare("--scan", Qt::CaseInsensitive) == 0)
+		else if((current.compare("--merge", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			QFileInfo partialFile(QDir::fromNativeSeparators(args.at(++i)));
+			if(partialFile.exists() && partialFile.isFile())
+			{
+				m_partialInputs << partialFile.canonicalFilePath();
+			}
+		}
+		else if((current.compare("--files-from", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			const QString listFile = args.at(++i);
+			QFileInfo info(QDir::fromNativeSeparators(listFile));
+			if(listFile.compare("-") == 0)
+			{
+				m_fileLists << listFile;
+			}
+			else if(info.exists() && info.isFile())
+			{
+				m_fileLists << info.canonicalFilePath();
+			}
+			else
+			{
+				qWarning("File list not found: %s", info.filePath().toUtf8().constData());
+			}
+		}
+		else if((current.compare("--partial-out", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			m_partialOutput = QDir::fromNativeSeparators(args.at(++i));
+			m_fileComparator->setPartialOutput(m_partialOutput);
+		}
+		else if((current.compare("--shard", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			const QStringList shard = args.at(++i).split('/');
+			if(shard.count() == 2)
+			{
+				m_directoryScanner->setShard(shard.at(0).toUInt(), shard.at(1).toUInt());
+			}
+		}
+		else if((current.compare("--workers", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			m_workerCount = qBound(0, args.at(++i).toInt(), 64);
+		}
+		else if((current.compare("--store", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			m_storeFile = QDir::fromNativeSeparators(args.at(++i));
+		}
+		else if((current.compare("--traversal", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			const QString order = args.at(++i).toLower();
+			if((order == "depth") || (order == "breadth") || (order == "hybrid"))
+			{
+				m_directoryScanner->setTraversalOrder((order == "depth") ? DirectoryScanner::TRAVERSAL_DEPTH_FIRST : ((order == "breadth") ? DirectoryScanner::TRAVERSAL_BREADTH_FIRST : DirectoryScanner::TRAVERSAL_HYBRID));
+				m_shardScanner->setTraversalOrder(order);
+			}
+			else
+			{
+				qWarning("Unknown traversal order \"%s\", ignoring!", order.toUtf8().constData());
+			}
+		}
+		else if(current.compare("--stream", Qt::CaseInsensitive) == 0)
 		{
-			appendNext = true;
+			m_streamFlag = true;
+		}
+		else if(current.compare("--watch", Qt::CaseInsensitive) == 0)
+		{
+			m_watchFlag = true;
+		}
+		else if((current.compare("--dir-cache", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			const QString cacheFile = QDir::fromNativeSeparators(args.at(++i));
+			m_directoryScanner->setCacheFile(cacheFile);
+			m_shardScanner->setCacheFile(cacheFile);
+		}
+		else if((current.compare("--diff", Qt::CaseInsensitive) == 0) && hasValue)
+		{
+			QFileInfo storeFile(QDir::fromNativeSeparators(args.at(++i)));
+			if(storeFile.exists() && storeFile.isFile())
+			{
+				m_diffFile = storeFile.canonicalFilePath();
+			}
+			else
+			{
+				qWarning("Result store not found: %s", storeFile.filePath().toUtf8().constData());
+			}
+		}
+		else if(m_scanFilter->parseArgument(args, i))
+		{
+			continue; /*one of the filter options*/
+		}
+		else if(current.compare("--shard-roots", Qt::CaseInsensitive) == 0)
+		{
+			m_shardScanner->setShardByRoots(true);
+		}
+		else if(current.compare("--no-recursive", Qt::CaseInsensitive) == 0)
+		{
+			m_recursiveFlag = false;
+		}
+		else if(current.compare("--overlaps", Qt::CaseInsensitive) == 0)
+		{
+			m_overlapFlag = true;
+		}
+		else if(current.compare("--similar", Qt::CaseInsensitive) == 0)
+		{
+			m_similarFlag = true;
+		}
+		else if(current.compare("--archives", Qt::CaseInsensitive) == 0)
+		{
+			m_archiveFlag = true;
+		}
+		else if(current.compare("--dirs", Qt::CaseInsensitive) == 0)
+		{
+			m_directoryMode = FileComparator::DIRECTORIES_NAMES;
+		}
+		else if(current.compare("--dirs-content", Qt::CaseInsensitive) == 0)
+		{
+			m_directoryMode = FileComparator::DIRECTORIES_CONTENT;
 		}
 	}
 
-	if(!m_droppedFolders.isEmpty())
+	if(!(m_droppedFolders.isEmpty() && m_partialInputs.isEmpty() && m_fileLists.isEmpty()))
 	{
 		m_unattendedFlag = true;
 		QTimer::singleShot(100, this, SLOT(startScan()));
 	}
 }
 
+void MainWindow::closeIfWorker(void)
+{
+	if(!m_partialOutput.isEmpty())
+	{
+		qDebug("Worker process is done, exiting.");
+		QTimer::singleShot(0, this, SLOT(close()));
+	}
+}
+
+void MainWindow::updateResultStore(void)
+{
+	if((m_storeFile.isEmpty() && m_diffFile.isEmpty()) || (!m_partialOutput.isEmpty()))
+	{
+		return;
+	}
+
+	QList<ResultStore::group_t> groups = m_model->duplicateGroups();
+	ResultStore::sortGroups(groups);
+
+	if(!m_diffFile.isEmpty())
+	{
+		QList<ResultStore::change_t> changes;
+		if(ResultStore::diff(m_diffFile, groups, changes))
+		{
+			m_model->clear();
+			for(QList<ResultStore::change_t>::ConstIterator iter = changes.constBegin(); iter != changes.constEnd(); iter++)
+			{
+				m_model->addChange(*iter);
+			}
+		}
+		else
+		{
+			qWarning("Failed to compare with result store: %s", m_diffFile.toUtf8().constData());
+		}
+	}
+
+	if(!m_storeFile.isEmpty())
+	{
+		if(!ResultStore::save(m_storeFile, groups))
+		{
+			qWarning("Failed to write result store: %s", m_storeFile.toUtf8().constData());
+		}
+	}
+}
+
 QModelIndex MainWindow::getSelectedItem(void)
 {
 	if(QItemSelectionModel *model = ui->treeView->selectionModel())
@@ -951,4 +1435,5 @@ void MainWindow::togglePause(void)
 	}
 	m_directoryScanner->suspend(m_pauseFlag);
 	m_fileComparator  ->suspend(m_pauseFlag);
+	m_shardScanner    ->suspend(m_pauseFlag);
 }
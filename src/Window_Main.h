@@ -24,6 +24,8 @@
 
 #include <QMainWindow>
 
+#include "ResultStore.h"
+
 //UIC forward declartion
 namespace Ui {
 	class MainWindow;
@@ -33,9 +35,13 @@ class QLabel;
 class QMovie;
 class DirectoryScanner;
 class FileComparator;
+class ShardScanner;
+class DirectoryWatcher;
+class ScanFilter;
 class DuplicatesModel;
 class QModelIndex;
 class QElapsedTimer;
+class QTimer;
 
 //MainWindow class
 class MainWindow: public QMainWindow
@@ -51,6 +57,7 @@ private slots:
 	void directoryScannerFinished(void);
 	void fileComparatorProgressChanged(const int &progress);
 	void fileComparatorFinished(void);
+	void watchedGroupChanged(const ResultStore::change_t &change);
 	void openFile(void);
 	void openFile(const QModelIndex &index);
 	void gotoFile(void);
@@ -63,6 +70,8 @@ private slots:
 	void exportToFile(void);
 	void copyToClipboard(void);
 	void autoClean(void);
+	void filterResults(void);
+	void searchResults(void);
 	void showHomepage(void);
 	void showAbout(void);
 
@@ -83,14 +92,18 @@ private:
 	void setMenuItemsEnabled(const bool &enabled);
 	void showSign(const int &id);
 	void handleCommandLineArgs(void);
+	void closeIfWorker(void);
+	void updateResultStore(void);
 	QModelIndex getSelectedItem(void);
 	void togglePause(void);
+	void applyFilter(const QString &text);
 	
 	static QString cleanFileName(const QString &fileName);
 
 	QLabel *m_animator;
 	QMovie *m_movie;
 	QElapsedTimer *m_timer;
+	QTimer *m_searchTimer;
 
 	QLabel *m_signCompleted;
 	QLabel *m_signCancelled;
@@ -100,13 +113,30 @@ private:
 	volatile bool m_abortFlag;
 	volatile bool m_pauseFlag;
 	volatile bool m_unattendedFlag;
+	bool m_recursiveFlag;
+	bool m_overlapFlag;
+	bool m_similarFlag;
+	bool m_archiveFlag;
+	int m_directoryMode;
+	bool m_shardMode;
+	bool m_watchFlag;
+	bool m_streamFlag;
 
 	QStringList m_droppedFolders;
+	QStringList m_partialInputs;
+	QStringList m_fileLists;
+	QString m_partialOutput;
+	QString m_storeFile;
+	QString m_diffFile;
 	QString m_unpauseText;
+	int m_workerCount;
 
 	DuplicatesModel *m_model;
 	DirectoryScanner *m_directoryScanner;
 	FileComparator *m_fileComparator;
+	ShardScanner *m_shardScanner;
+	DirectoryWatcher *m_directoryWatcher;
+	ScanFilter *m_scanFilter;
 
 	Ui::MainWindow *const ui;
 };